@@ -35,6 +35,7 @@ struct RoomsData {
     std::vector<std::string> room_names;
     std::vector<int> room_player_counts;
     std::vector<int> room_in_game;
+    std::vector<int> room_ids;
 };
 
 struct JoinData {
@@ -58,6 +59,11 @@ struct RankingData {
     std::string ranking_text;
 };
 
+struct TimeData {
+    AppWidgets *widgets;
+    int time_left;
+};
+
 class AppWidgets {
 public:
     GtkWidget *connection_window;
@@ -383,6 +389,89 @@ static gboolean handle_ranking_full(gpointer data) {
     return FALSE;
 }
 
+static void set_time_left(AppWidgets *w, int time_left) {
+    w->time_left = time_left;
+    
+    if (w->game_time_label && GTK_IS_LABEL(w->game_time_label)) {
+        char time_text[50];
+        snprintf(time_text, sizeof(time_text), "<span size='large'><b>Czas:</b> %ds</span>", w->time_left);
+        gtk_label_set_markup(GTK_LABEL(w->game_time_label), time_text);
+    }
+}
+
+static gboolean update_time_left(gpointer data) {
+    TimeData *td = (TimeData*)data;
+    set_time_left(td->widgets, td->time_left);
+    delete td;
+    return FALSE;
+}
+
+static void render_game_state(AppWidgets *w) {
+    if (!w->game_players_box || !GTK_IS_BOX(w->game_players_box)) {
+        return;
+    }
+    
+    clear_container(w->game_players_box);
+    
+    for (int i = 0; i < w->player_count; i++) {
+        PlayerState *p = &w->players[i];
+        
+        if (strcmp(p->name, w->player_name) == 0) {
+            char spaced_progress[256];
+            int idx = 0;
+            for (int j = 0; p->progress[j] != '\0' && idx < 254; j++) {
+                spaced_progress[idx++] = p->progress[j];
+                spaced_progress[idx++] = ' ';
+            }
+            spaced_progress[idx > 0 ? idx - 1 : 0] = '\0';
+            
+            if (w->game_word_label && GTK_IS_LABEL(w->game_word_label)) {
+                char word_text[256];
+                snprintf(word_text, sizeof(word_text), "<span size='xx-large'><b>%s</b></span>", spaced_progress);
+                gtk_label_set_markup(GTK_LABEL(w->game_word_label), word_text);
+            }
+            
+            if (w->game_hangman_label && GTK_IS_LABEL(w->game_hangman_label) &&
+                p->hangman_state >= 0 && p->hangman_state <= 6) {
+                gtk_label_set_text(GTK_LABEL(w->game_hangman_label), hangman_stages[p->hangman_state]);
+            }
+            
+            if (w->game_wrong_letters_label && GTK_IS_LABEL(w->game_wrong_letters_label)) {
+                char wrong_text[100];
+                snprintf(wrong_text, sizeof(wrong_text), "Błędne litery: %s", p->wrong_letters);
+                gtk_label_set_text(GTK_LABEL(w->game_wrong_letters_label), wrong_text);
+            }
+            
+            continue;
+        }
+        
+        char player_info[256];
+        const char *status = "";
+        if (p->has_guessed) {
+            status = "[zgadł]";
+        } else if (!p->active) {
+            status = "[odpadł]";
+        }
+        
+        snprintf(player_info, sizeof(player_info), "%s: odgadnięte litery: %d/%d (błędów: %d) %s", 
+                 p->name, p->guessed_count, w->word_length, p->hangman_state, status);
+        
+        GtkWidget *frame = gtk_frame_new(NULL);
+        GtkWidget *label = gtk_label_new(player_info);
+        gtk_label_set_xalign(GTK_LABEL(label), 0.0);
+        gtk_container_set_border_width(GTK_CONTAINER(frame), 5);
+        gtk_container_add(GTK_CONTAINER(frame), label);
+        gtk_box_pack_start(GTK_BOX(w->game_players_box), frame, FALSE, FALSE, 2);
+    }
+    
+    gtk_widget_show_all(w->game_players_box);
+    
+    if (w->game_window && GTK_IS_WIDGET(w->game_window) &&
+        w->game_entry_letter && GTK_IS_WIDGET(w->game_entry_letter)) {
+        gtk_widget_grab_focus(w->game_entry_letter);
+    }
+}
+
 static gboolean update_game_state(gpointer data) {
     GameStateData *gsd = (GameStateData*)data;
     AppWidgets *w = gsd->widgets;
@@ -409,29 +498,20 @@ static gboolean update_game_state(gpointer data) {
         delete gsd;
         return FALSE;
     }
-    w->time_left = atoi(token);
-    
-    if (w->game_time_label && GTK_IS_LABEL(w->game_time_label)) {
-        char time_text[50];
-        snprintf(time_text, sizeof(time_text), "<span size='large'><b>Czas:</b> %ds</span>", w->time_left);
-        gtk_label_set_markup(GTK_LABEL(w->game_time_label), time_text);
-    }
+    set_time_left(w, atoi(token));
     
     token = strtok_r(NULL, " ", &saveptr);
     if (!token) {
         delete gsd;
         return FALSE;
     }
-    w->player_count = atoi(token);
     
-    if (w->game_players_box && GTK_IS_BOX(w->game_players_box)) {
-        clear_container(w->game_players_box);
-    } else {
-        delete gsd;
-        return FALSE;
-    }
+    int announced = atoi(token);
+    delete[] w->players;
+    w->players = new PlayerState[announced > 0 ? announced : 1];
+    w->player_count = 0;
     
-    for (int i = 0; i < w->player_count; i++) {
+    for (int i = 0; i < announced; i++) {
         token = strtok_r(NULL, " ", &saveptr);
         if (!token) break;
         
@@ -457,76 +537,82 @@ static gboolean update_game_state(gpointer data) {
             continue;
         }
         
-        char *name = parts[0];
-        char *hangman_str = parts[1];
-        char *guessed_count_str = parts[2];
-        char *wrong_letters = parts[3];
-        char *active_str = parts[4];
-        char *has_guessed_str = parts[5];
-        char *progress_self = parts[6];
-        
-        int hangman_state = atoi(hangman_str);
-        int guessed_count = atoi(guessed_count_str);
-        bool active = atoi(active_str) != 0;
-        bool has_guessed = atoi(has_guessed_str) != 0;
+        PlayerState *p = &w->players[w->player_count++];
+        memset(p, 0, sizeof(*p));
+        strncpy(p->name, parts[0], sizeof(p->name) - 1);
+        p->hangman_state = atoi(parts[1]);
+        p->guessed_count = atoi(parts[2]);
+        strncpy(p->wrong_letters, parts[3], sizeof(p->wrong_letters) - 1);
+        p->active = atoi(parts[4]) != 0;
+        p->has_guessed = atoi(parts[5]) != 0;
+        strncpy(p->progress, parts[6], sizeof(p->progress) - 1);
         
-        if (strcmp(name, w->player_name) == 0) {
-            char spaced_progress[256];
-            int idx = 0;
-            for (int j = 0; progress_self[j] != '\0' && idx < 254; j++) {
-                spaced_progress[idx++] = progress_self[j];
-                spaced_progress[idx++] = ' ';
-            }
-            if (idx > 0) spaced_progress[idx-1] = '\0';
-            
-            if (w->game_word_label && GTK_IS_LABEL(w->game_word_label)) {
-                char word_text[256];
-                snprintf(word_text, sizeof(word_text), "<span size='xx-large'><b>%s</b></span>", spaced_progress);
-                gtk_label_set_markup(GTK_LABEL(w->game_word_label), word_text);
-            }
-            
-            if (w->game_hangman_label && GTK_IS_LABEL(w->game_hangman_label) &&
-                hangman_state >= 0 && hangman_state <= 6) {
-                gtk_label_set_text(GTK_LABEL(w->game_hangman_label), hangman_stages[hangman_state]);
-            }
-            
-            if (w->game_wrong_letters_label && GTK_IS_LABEL(w->game_wrong_letters_label)) {
-                char wrong_text[100];
-                snprintf(wrong_text, sizeof(wrong_text), "Błędne litery: %s", wrong_letters);
-                gtk_label_set_text(GTK_LABEL(w->game_wrong_letters_label), wrong_text);
-            }
-            
-            free(player_data);
-            continue;
+        free(player_data);
+    }
+    
+    render_game_state(w);
+    
+    delete gsd;
+    return FALSE;
+}
+
+// GAME_DELTA <gracz> <pole>=<wartość>... zmienia tylko podane pola gracza
+// zapamiętanego z ostatniego pełnego GAME.
+static gboolean apply_game_delta(gpointer data) {
+    GameStateData *gsd = (GameStateData*)data;
+    AppWidgets *w = gsd->widgets;
+    std::string line = gsd->game_state_line;
+    
+    char *saveptr;
+    char *line_cstr = const_cast<char*>(line.c_str());
+    char *token = strtok_r(line_cstr, " ", &saveptr);
+    char *name = strtok_r(NULL, " ", &saveptr);
+    
+    PlayerState *p = nullptr;
+    for (int i = 0; name && i < w->player_count; i++) {
+        if (strcmp(w->players[i].name, name) == 0) {
+            p = &w->players[i];
+            break;
         }
-        
-        char player_info[256];
-        const char *status = "";
-        if (has_guessed) {
-            status = "[zgadł]";
-        } else if (!active) {
-            status = "[odpadł]";
+    }
+    
+    if (!token || !p) {
+        delete gsd;
+        return FALSE;
+    }
+    
+    while ((token = strtok_r(NULL, " ", &saveptr))) {
+        if (strlen(token) < 2 || token[1] != '=') {
+            continue;
         }
         
-        snprintf(player_info, sizeof(player_info), "%s: odgadnięte litery: %d/%d (błędów: %d) %s", 
-                 name, guessed_count, w->word_length, hangman_state, status);
-        
-        GtkWidget *frame = gtk_frame_new(NULL);
-        GtkWidget *label = gtk_label_new(player_info);
-        gtk_label_set_xalign(GTK_LABEL(label), 0.0);
-        gtk_container_set_border_width(GTK_CONTAINER(frame), 5);
-        gtk_container_add(GTK_CONTAINER(frame), label);
-        gtk_box_pack_start(GTK_BOX(w->game_players_box), frame, FALSE, FALSE, 2);
+        const char *value = token + 2;
         
-        free(player_data);
+        switch (token[0]) {
+        case 's':
+            p->hangman_state = atoi(value);
+            break;
+        case 'g':
+            p->guessed_count = atoi(value);
+            break;
+        case 'w':
+            strncpy(p->wrong_letters, value, sizeof(p->wrong_letters) - 1);
+            p->wrong_letters[sizeof(p->wrong_letters) - 1] = '\0';
+            break;
+        case 'a':
+            p->active = atoi(value) != 0;
+            break;
+        case 'd':
+            p->has_guessed = atoi(value) != 0;
+            break;
+        case 'p':
+            strncpy(p->progress, value, sizeof(p->progress) - 1);
+            p->progress[sizeof(p->progress) - 1] = '\0';
+            break;
+        }
     }
     
-    gtk_widget_show_all(w->game_players_box);
-    
-    if (w->game_window && GTK_IS_WIDGET(w->game_window) &&
-        w->game_entry_letter && GTK_IS_WIDGET(w->game_entry_letter)) {
-        gtk_widget_grab_focus(w->game_entry_letter);
-    }
+    render_game_state(w);
     
     delete gsd;
     return FALSE;
@@ -571,7 +657,7 @@ static gboolean update_rooms_list(gpointer data) {
             GtkWidget *btn = gtk_button_new_with_label("Dołącz");
             JoinData *jd = new JoinData;
             jd->widgets = w;
-            jd->room_id = i;
+            jd->room_id = rd->room_ids[i];
             g_signal_connect(btn, "clicked", G_CALLBACK(join_room_clicked), jd);
             gtk_box_pack_start(GTK_BOX(vbox), btn, FALSE, FALSE, 2);
         } else if (rd->room_in_game[i]) {
@@ -1197,6 +1283,7 @@ static void connect_clicked(GtkWidget *button, gpointer data) {
     }
     
     send_message(w->sock, "NAME %s\n", name);
+    send_message(w->sock, "DELTA ON\n");
     
     if (button && GTK_IS_BUTTON(button)) {
         gtk_widget_set_sensitive(button, FALSE);
@@ -1249,7 +1336,7 @@ static void connect_clicked(GtkWidget *button, gpointer data) {
                             if (!token) break;
                             
                             char *room_info = strdup(token);
-                            char *parts[3];
+                            char *parts[4];
                             int part_idx = 0;
                             char *start = room_info;
                             
@@ -1277,6 +1364,14 @@ static void connect_clicked(GtkWidget *button, gpointer data) {
                                 rd->room_in_game.push_back(0);
                             }
                             
+                            // Uchwyt pokoju do JOIN; starszy serwer go nie wysyła,
+                            // wtedy numerem jest pozycja na liście.
+                            if (part_idx >= 3) {
+                                rd->room_ids.push_back(atoi(parts[3]));
+                            } else {
+                                rd->room_ids.push_back(i);
+                            }
+                            
                             free(room_info);
                         }
                         
@@ -1341,6 +1436,13 @@ static void connect_clicked(GtkWidget *button, gpointer data) {
                         }
                         g_idle_add(safe_show_window, w->room_window);
                     }
+                    else if (strncmp(line, "GAME_DELTA", 10) == 0) {
+                        GameStateData *gsd = new GameStateData;
+                        gsd->widgets = w;
+                        gsd->game_state_line = line;
+                        
+                        g_idle_add(apply_game_delta, gsd);
+                    }
                     else if (strncmp(line, "GAME", 4) == 0) {
                         g_idle_add(switch_to_game_window_safe, w);
                         
@@ -1348,7 +1450,14 @@ static void connect_clicked(GtkWidget *button, gpointer data) {
                         gsd->widgets = w;
                         gsd->game_state_line = line;
                         
-                        g_timeout_add(200, update_game_state, gsd);
+                        g_idle_add(update_game_state, gsd);
+                    }
+                    else if (strncmp(line, "TIME", 4) == 0) {
+                        TimeData *td = new TimeData;
+                        td->widgets = w;
+                        td->time_left = atoi(line + 5);
+                        
+                        g_idle_add(update_time_left, td);
                     }
                     else if (strncmp(line, "ROOM_LOBBY", 10) == 0) {
                         bool disconnecting = w->disconnecting.load();
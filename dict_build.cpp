@@ -0,0 +1,59 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include "dictionary.h"
+
+// Buduje binarny słownik dla serwera z pliku tekstowego (jedno słowo w linii).
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        std::cerr << "Użycie: " << argv[0] << " słowa.txt słownik.dict" << std::endl;
+        return 1;
+    }
+
+    std::ifstream in(argv[1]);
+    if (!in) {
+        std::cerr << "Nie można otworzyć " << argv[1] << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> words;
+    std::string line;
+    size_t lines = 0;
+
+    while (std::getline(in, line)) {
+        lines++;
+        while (!line.empty() && isspace((unsigned char)line.back()))
+            line.pop_back();
+        words.push_back(line);
+    }
+
+    std::vector<char> image = build_dictionary_image(words);
+
+    // Zapis przez plik tymczasowy i rename: serwer może mieć stary słownik
+    // zmapowany w pamięci, więc nie wolno go nadpisywać w miejscu.
+    std::string tmp = std::string(argv[2]) + ".tmp";
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    out.write(image.data(), image.size());
+    out.close();
+
+    if (!out || rename(tmp.c_str(), argv[2]) < 0) {
+        std::cerr << "Błąd zapisu " << argv[2] << std::endl;
+        remove(tmp.c_str());
+        return 1;
+    }
+
+    Dictionary dict;
+    dict.load(std::move(image));
+
+    std::cout << "Zapisano " << dict.word_count() << " haseł z " << lines
+              << " linii do " << argv[2] << std::endl;
+    for (int d = 0; d < DICT_DIFFICULTIES; d++) {
+        WordCriteria c;
+        c.difficulty = d;
+        std::cout << "  trudność " << d << ": " << dict.count(c) << std::endl;
+    }
+
+    return 0;
+}
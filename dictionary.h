@@ -0,0 +1,464 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <map>
+#include <deque>
+#include <tuple>
+#include <mutex>
+#include <memory>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Binarny słownik haseł (plik .dict budowany przez dict_build).
+//
+// Układ pliku:
+//   DictHeader
+//   uint32_t cells[DICT_CELLS + 1]   - początki komórek indeksu
+//   DictEntry entries[word_count]    - posortowane wg (trudność, długość, litery)
+//   char words[]                     - litery haseł bez separatorów
+//
+// Komórka indeksu to jedna kombinacja (trudność, długość, liczba różnych
+// liter), a jej hasła leżą obok siebie w entries. Dzięki kolejności sortowania
+// zakres dla ustalonej trudności i długości też jest ciągły, więc losowanie
+// hasła spełniającego kryteria nie zależy od rozmiaru słownika. Każdy wpis
+// ma też maskę swoich liter, więc warunek na zbiór liter ("zawiera K i Z, nie
+// zawiera Q") to dwie operacje na masce zamiast czytania słowa. Takiego
+// warunku indeks nie zawęża, więc wynik przeglądu zakresów jest zapamiętywany
+// w słowniku (LetterMatches) i kolejne zapytania o te same kryteria go nie
+// powtarzają.
+
+const char DICT_MAGIC[8] = {'W', 'I', 'S', 'D', 'I', 'C', 'T', '1'};
+
+const int DICT_DIFFICULTIES = 3;
+const int DICT_MAX_LENGTH = 64;
+const int DICT_MAX_DISTINCT = 26;
+const int DICT_CELLS = DICT_DIFFICULTIES * (DICT_MAX_LENGTH + 1) * (DICT_MAX_DISTINCT + 1);
+
+struct DictHeader {
+    char magic[8];
+    uint32_t word_count;
+    uint32_t cell_count;
+    uint64_t cells_offset;
+    uint64_t entries_offset;
+    uint64_t words_offset;
+    uint64_t total_size;
+};
+
+struct DictEntry {
+    uint32_t offset;
+    uint8_t length;
+    uint8_t difficulty;
+    uint8_t distinct;
+    uint8_t reserved;
+    uint32_t letters;
+};
+
+inline int dict_cell(int difficulty, int length, int distinct) {
+    return (difficulty * (DICT_MAX_LENGTH + 1) + length) * (DICT_MAX_DISTINCT + 1) + distinct;
+}
+
+// Sprowadza słowo do wielkich liter A-Z, zamieniając polskie znaki na ich
+// odpowiedniki bez ogonków (tak jak w haśle "ZWYCIESTWO"). Zwraca pusty napis,
+// gdy słowo zawiera coś innego niż litery.
+inline std::string normalize_word(const std::string& word) {
+    std::string out;
+
+    for (size_t i = 0; i < word.size(); i++) {
+        unsigned char ch = word[i];
+
+        if (ch < 0x80) {
+            if (!isalpha(ch))
+                return "";
+            out += (char)toupper(ch);
+            continue;
+        }
+
+        if ((ch & 0xE0) != 0xC0 || i + 1 >= word.size())
+            return "";
+
+        unsigned cp = ((ch & 0x1F) << 6) | ((unsigned char)word[i + 1] & 0x3F);
+        i++;
+
+        switch (cp) {
+        case 0x0104: case 0x0105: out += 'A'; break;
+        case 0x0106: case 0x0107: out += 'C'; break;
+        case 0x0118: case 0x0119: out += 'E'; break;
+        case 0x0141: case 0x0142: out += 'L'; break;
+        case 0x0143: case 0x0144: out += 'N'; break;
+        case 0x00D3: case 0x00F3: out += 'O'; break;
+        case 0x015A: case 0x015B: out += 'S'; break;
+        case 0x0179: case 0x017A:
+        case 0x017B: case 0x017C: out += 'Z'; break;
+        default:
+            return "";
+        }
+    }
+
+    return out;
+}
+
+inline uint32_t word_letters(const std::string& word) {
+    uint32_t letters = 0;
+    for (char ch : word)
+        letters |= 1u << (ch - 'A');
+    return letters;
+}
+
+// Trudność 0-2: liczba różnych liter spoza najczęstszych w polskim tekście,
+// plus jeden poziom dla krótkich słów, w których trudniej coś odgadnąć.
+inline int word_difficulty(const std::string& word) {
+    static const uint32_t common = word_letters("AEIOZNRWSCTKYDPMUJL");
+
+    int score = __builtin_popcount(word_letters(word) & ~common);
+    if (word.size() <= 5)
+        score++;
+
+    return std::min(score, DICT_DIFFICULTIES - 1);
+}
+
+// Buduje obraz słownika w pamięci; dict_build zapisuje go do pliku, a serwer
+// używa go bezpośrednio, gdy nie podano pliku słownika.
+inline std::vector<char> build_dictionary_image(const std::vector<std::string>& source) {
+    std::vector<std::string> words;
+
+    for (const auto& w : source) {
+        std::string n = normalize_word(w);
+        if (n.size() >= 2 && n.size() <= (size_t)DICT_MAX_LENGTH)
+            words.push_back(n);
+    }
+
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+
+    std::vector<DictEntry> entries;
+    std::string chars;
+
+    for (const auto& w : words) {
+        DictEntry e{};
+        e.offset = chars.size();
+        e.length = w.size();
+        e.difficulty = word_difficulty(w);
+        e.letters = word_letters(w);
+        e.distinct = __builtin_popcount(e.letters);
+        entries.push_back(e);
+        chars += w;
+    }
+
+    std::stable_sort(entries.begin(), entries.end(),
+        [](const DictEntry& a, const DictEntry& b) {
+            return dict_cell(a.difficulty, a.length, a.distinct) <
+                   dict_cell(b.difficulty, b.length, b.distinct);
+        });
+
+    std::vector<uint32_t> cells(DICT_CELLS + 1, 0);
+    for (const auto& e : entries)
+        cells[dict_cell(e.difficulty, e.length, e.distinct) + 1]++;
+    for (int i = 0; i < DICT_CELLS; i++)
+        cells[i + 1] += cells[i];
+
+    DictHeader h{};
+    memcpy(h.magic, DICT_MAGIC, sizeof(h.magic));
+    h.word_count = entries.size();
+    h.cell_count = DICT_CELLS;
+    h.cells_offset = sizeof(DictHeader);
+    h.entries_offset = h.cells_offset + cells.size() * sizeof(uint32_t);
+    h.words_offset = h.entries_offset + entries.size() * sizeof(DictEntry);
+    h.total_size = h.words_offset + chars.size();
+
+    std::vector<char> image(h.total_size);
+    memcpy(image.data(), &h, sizeof(h));
+    memcpy(image.data() + h.cells_offset, cells.data(), cells.size() * sizeof(uint32_t));
+    if (!entries.empty())
+        memcpy(image.data() + h.entries_offset, entries.data(), entries.size() * sizeof(DictEntry));
+    memcpy(image.data() + h.words_offset, chars.data(), chars.size());
+
+    return image;
+}
+
+// Kryteria losowania hasła; -1 oznacza dowolną wartość. letters i excluded
+// to maski liter (bit 0 = 'A'), które hasło musi zawierać / nie może zawierać.
+struct WordCriteria {
+    int difficulty = -1;
+    int length = -1;
+    int distinct = -1;
+    uint32_t letters = 0;
+    uint32_t excluded = 0;
+
+    bool has_letters() const {
+        return letters != 0 || excluded != 0;
+    }
+
+    bool matches(const DictEntry& e) const {
+        return (e.letters & letters) == letters && (e.letters & excluded) == 0;
+    }
+};
+
+// Wynik przeglądu zakresów dla kryteriów z warunkiem na litery: liczba
+// pasujących haseł i ich równomierna próbka (indeksy entries; wszystkie, gdy
+// jest ich nie więcej niż SAMPLE).
+struct LetterMatches {
+    static const size_t SAMPLE = 4096;
+
+    uint32_t total = 0;
+    std::vector<uint32_t> sample;
+};
+
+// Widok na obraz słownika - z pliku zmapowanego mmap albo z pamięci.
+struct Dictionary {
+    const char* base = nullptr;
+    size_t size = 0;
+    bool mapped = false;
+    std::vector<char> image;
+
+    const DictHeader* header = nullptr;
+    const uint32_t* cells = nullptr;
+    const DictEntry* entries = nullptr;
+    const char* words = nullptr;
+
+    using LetterKey = std::tuple<int, int, int, uint32_t, uint32_t>;
+    static const size_t LETTER_CACHE_SIZE = 1024;
+
+    mutable std::mutex letter_mutex;
+    mutable std::map<LetterKey, std::shared_ptr<const LetterMatches>> letter_cache;
+    mutable std::deque<LetterKey> letter_order;
+
+    Dictionary() = default;
+    Dictionary(const Dictionary&) = delete;
+    Dictionary& operator=(const Dictionary&) = delete;
+
+    ~Dictionary() {
+        if (mapped)
+            munmap(const_cast<char*>(base), size);
+    }
+
+    bool attach() {
+        if (size < sizeof(DictHeader))
+            return false;
+
+        header = reinterpret_cast<const DictHeader*>(base);
+        if (memcmp(header->magic, DICT_MAGIC, sizeof(DICT_MAGIC)) != 0 ||
+            header->cell_count != (uint32_t)DICT_CELLS ||
+            header->total_size != size ||
+            header->cells_offset < sizeof(DictHeader) ||
+            header->cells_offset + (DICT_CELLS + 1) * sizeof(uint32_t) > header->entries_offset ||
+            header->words_offset > size ||
+            header->entries_offset + (uint64_t)header->word_count * sizeof(DictEntry) > header->words_offset)
+            return false;
+
+        cells = reinterpret_cast<const uint32_t*>(base + header->cells_offset);
+        entries = reinterpret_cast<const DictEntry*>(base + header->entries_offset);
+        words = base + header->words_offset;
+        if (cells[DICT_CELLS] != header->word_count)
+            return false;
+
+        uint64_t chars = size - header->words_offset;
+        for (uint32_t i = 0; i < header->word_count; i++)
+            if ((uint64_t)entries[i].offset + entries[i].length > chars)
+                return false;
+
+        return true;
+    }
+
+    bool open(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        struct stat st;
+        if (fstat(fd, &st) < 0 || st.st_size == 0) {
+            ::close(fd);
+            return false;
+        }
+
+        void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED)
+            return false;
+
+        madvise(p, st.st_size, MADV_RANDOM);
+
+        base = static_cast<const char*>(p);
+        size = st.st_size;
+        mapped = true;
+        return attach();
+    }
+
+    bool load(std::vector<char> data) {
+        image = std::move(data);
+        base = image.data();
+        size = image.size();
+        return attach();
+    }
+
+    uint32_t word_count() const {
+        return header ? header->word_count : 0;
+    }
+
+    // Wywołuje f(begin, end) dla każdego niepustego zakresu entries pasującego
+    // do kryteriów - co najwyżej DICT_DIFFICULTIES * (DICT_MAX_LENGTH + 1),
+    // niezależnie od liczby haseł.
+    template <typename F>
+    void for_each_range(const WordCriteria& c, F&& f) const {
+        int d0 = c.difficulty < 0 ? 0 : c.difficulty;
+        int d1 = c.difficulty < 0 ? DICT_DIFFICULTIES - 1 : c.difficulty;
+        int l0 = c.length < 0 ? 0 : c.length;
+        int l1 = c.length < 0 ? DICT_MAX_LENGTH : c.length;
+        int k0 = c.distinct < 0 ? 0 : c.distinct;
+        int k1 = c.distinct < 0 ? DICT_MAX_DISTINCT : c.distinct;
+
+        if (d1 >= DICT_DIFFICULTIES || l1 > DICT_MAX_LENGTH || k1 > DICT_MAX_DISTINCT)
+            return;
+
+        for (int d = d0; d <= d1; d++) {
+            // Bez ograniczenia liczby liter długości l0..l1 leżą obok siebie.
+            if (c.distinct < 0) {
+                uint32_t begin = cells[dict_cell(d, l0, 0)];
+                uint32_t end = cells[dict_cell(d, l1, DICT_MAX_DISTINCT) + 1];
+                if (begin < end)
+                    f(begin, end);
+                continue;
+            }
+
+            for (int l = l0; l <= l1; l++) {
+                uint32_t begin = cells[dict_cell(d, l, k0)];
+                uint32_t end = cells[dict_cell(d, l, k1) + 1];
+                if (begin < end)
+                    f(begin, end);
+            }
+        }
+    }
+
+    // Liczba haseł w zakresach indeksu, bez warunku na litery.
+    uint32_t range_count(const WordCriteria& c) const {
+        uint32_t total = 0;
+        if (header)
+            for_each_range(c, [&](uint32_t b, uint32_t e) { total += e - b; });
+        return total;
+    }
+
+    // n-te hasło z zakresów pasujących do kryteriów (bez warunku na litery).
+    const DictEntry* range_entry(const WordCriteria& c, uint32_t n) const {
+        const DictEntry* chosen = nullptr;
+
+        for_each_range(c, [&](uint32_t b, uint32_t e) {
+            if (!chosen && n < e - b)
+                chosen = &entries[b + n];
+            else if (!chosen)
+                n -= e - b;
+        });
+
+        return chosen;
+    }
+
+    static LetterKey letter_key(const WordCriteria& c) {
+        return LetterKey(c.difficulty, c.length, c.distinct, c.letters, c.excluded);
+    }
+
+    // Zapamiętany wynik dla kryteriów albo nullptr; nie przegląda słownika.
+    std::shared_ptr<const LetterMatches> cached_matches(const WordCriteria& c) const {
+        std::lock_guard<std::mutex> lock(letter_mutex);
+        auto it = letter_cache.find(letter_key(c));
+        return it == letter_cache.end() ? nullptr : it->second;
+    }
+
+    // Przegląda maski we wszystkich pasujących zakresach (przy milionach haseł
+    // to milisekundy - nie wołać z wątku reaktora) i zapamiętuje wynik;
+    // najstarsze wyniki wypadają po LETTER_CACHE_SIZE różnych kryteriach.
+    std::shared_ptr<const LetterMatches> letter_matches(const WordCriteria& c) const {
+        if (auto cached = cached_matches(c))
+            return cached;
+
+        auto fresh = std::make_shared<LetterMatches>();
+        std::mt19937 gen(c.letters ^ c.excluded);
+
+        if (header)
+            for_each_range(c, [&](uint32_t b, uint32_t e) {
+                for (uint32_t i = b; i < e; i++) {
+                    if (!c.matches(entries[i]))
+                        continue;
+
+                    fresh->total++;
+                    if (fresh->sample.size() < LetterMatches::SAMPLE)
+                        fresh->sample.push_back(i);
+                    else if (uint32_t j = gen() % fresh->total; j < LetterMatches::SAMPLE)
+                        fresh->sample[j] = i;
+                }
+            });
+
+        std::lock_guard<std::mutex> lock(letter_mutex);
+        auto inserted = letter_cache.emplace(letter_key(c), fresh);
+        if (!inserted.second)
+            return inserted.first->second;
+
+        letter_order.push_back(letter_key(c));
+        if (letter_order.size() > LETTER_CACHE_SIZE) {
+            letter_cache.erase(letter_order.front());
+            letter_order.pop_front();
+        }
+        return fresh;
+    }
+
+    // Przelicza w tym słowniku kryteria zapamiętane w poprzednim, żeby po
+    // przeładowaniu pokoje z warunkiem na litery nie czekały na przegląd.
+    void warm_from(const Dictionary& old) const {
+        std::deque<LetterKey> keys;
+        {
+            std::lock_guard<std::mutex> lock(old.letter_mutex);
+            keys = old.letter_order;
+        }
+
+        for (const LetterKey& k : keys) {
+            WordCriteria c;
+            std::tie(c.difficulty, c.length, c.distinct, c.letters, c.excluded) = k;
+            letter_matches(c);
+        }
+    }
+
+    // Z warunkiem na litery liczba pochodzi z przeglądu (letter_matches).
+    uint32_t count(const WordCriteria& c) const {
+        if (!c.has_letters())
+            return range_count(c);
+        return letter_matches(c)->total;
+    }
+
+    // Z warunkiem na litery nie przegląda słownika: po nieudanym losowaniu
+    // z odrzucaniem bierze hasło z zapamiętanej próbki, a bez niej zwraca
+    // false. Kryteria trzeba więc wcześniej sprawdzić przez count().
+    bool pick(const WordCriteria& c, std::mt19937& gen, std::string& out) const {
+        static const int LETTER_TRIES = 64;
+
+        uint32_t total = range_count(c);
+        if (total == 0)
+            return false;
+
+        std::uniform_int_distribution<uint32_t> any(0, total - 1);
+        const DictEntry* chosen = nullptr;
+
+        // Warunek na litery spełnia zwykle spora część zakresu, więc najpierw
+        // losowanie z odrzucaniem; próbka dopiero dla rzadkich zbiorów.
+        for (int i = 0; i < (c.has_letters() ? LETTER_TRIES : 1) && !chosen; i++) {
+            const DictEntry* e = range_entry(c, any(gen));
+            if (c.matches(*e))
+                chosen = e;
+        }
+
+        if (!chosen) {
+            std::shared_ptr<const LetterMatches> matches = cached_matches(c);
+            if (!matches || matches->sample.empty())
+                return false;
+
+            size_t n = std::uniform_int_distribution<size_t>(0, matches->sample.size() - 1)(gen);
+            chosen = &entries[matches->sample[n]];
+        }
+
+        out.assign(words + chosen->offset, chosen->length);
+        return true;
+    }
+};
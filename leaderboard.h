@@ -0,0 +1,299 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <algorithm>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <memory>
+#include <chrono>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Trwała tablica najlepszych wyników.
+//
+// <plik>.log - dopisywane rekordy LeaderboardEntry, po jednym na odgadnięte
+//              hasło; pełna historia, czytana tylko przy odbudowie indeksu.
+// <plik>.idx - zmapowany indeks: najlepsze wyniki wszech czasów i bieżącego
+//              dnia (UTC) oraz liczba rekordów logu, które już uwzględnia.
+//
+// Po restarcie indeks jest używany bez czytania historii; doczytywany jest
+// tylko ogon logu zapisany po ostatniej aktualizacji indeksu. Uszkodzony
+// albo brakujący indeks jest odbudowywany z całego logu.
+//
+// Reaktor tylko wstawia wynik do kolejki; zapisem na dysk i aktualizacją
+// indeksu zajmuje się osobny wątek, więc wygrana nie czeka na write().
+
+const char LEADERBOARD_MAGIC[8] = {'W', 'I', 'S', 'T', 'O', 'P', 'K', '1'};
+
+const int LEADERBOARD_TOP = 10;
+const int LEADERBOARD_NAME = 32;
+
+struct LeaderboardEntry {
+    uint32_t duration_ms;
+    uint8_t errors;
+    uint8_t name_len;
+    uint16_t reserved;
+    int64_t unix_ms;
+    char name[LEADERBOARD_NAME];
+};
+
+struct LeaderboardIndex {
+    char magic[8];
+    uint64_t applied;
+    int64_t day;
+    uint32_t all_count;
+    uint32_t day_count;
+    LeaderboardEntry all[LEADERBOARD_TOP];
+    LeaderboardEntry today[LEADERBOARD_TOP];
+};
+
+inline bool leaderboard_better(const LeaderboardEntry& a, const LeaderboardEntry& b) {
+    if (a.duration_ms != b.duration_ms)
+        return a.duration_ms < b.duration_ms;
+    if (a.errors != b.errors)
+        return a.errors < b.errors;
+    return a.unix_ms < b.unix_ms;
+}
+
+// Wstawia wynik do posortowanej listy, jeśli mieści się w pierwszej dziesiątce.
+inline void leaderboard_insert(LeaderboardEntry* top, uint32_t& count, const LeaderboardEntry& e) {
+    uint32_t pos = count;
+    while (pos > 0 && leaderboard_better(e, top[pos - 1]))
+        pos--;
+
+    if (pos >= (uint32_t)LEADERBOARD_TOP)
+        return;
+
+    uint32_t last = count < (uint32_t)LEADERBOARD_TOP ? count : LEADERBOARD_TOP - 1;
+    memmove(&top[pos + 1], &top[pos], (last - pos) * sizeof(LeaderboardEntry));
+    top[pos] = e;
+
+    if (count < (uint32_t)LEADERBOARD_TOP)
+        count++;
+}
+
+inline int64_t leaderboard_day(int64_t unix_ms) {
+    return unix_ms / 86400000;
+}
+
+struct Leaderboard {
+    std::mutex mutex;
+    int log_fd = -1;
+    LeaderboardIndex* index = nullptr;
+    uint64_t version = 0;
+    std::shared_ptr<const std::string> replies[2];
+    uint64_t reply_version[2] = {};
+
+    std::vector<LeaderboardEntry> pending;
+    std::condition_variable wake;
+    bool stopping = false;
+    std::thread writer;
+
+    Leaderboard() = default;
+    Leaderboard(const Leaderboard&) = delete;
+    Leaderboard& operator=(const Leaderboard&) = delete;
+
+    ~Leaderboard() {
+        if (writer.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            wake.notify_one();
+            writer.join();
+        }
+
+        if (index)
+            munmap(index, sizeof(LeaderboardIndex));
+        if (log_fd >= 0)
+            ::close(log_fd);
+    }
+
+    void apply(const LeaderboardEntry& e) {
+        leaderboard_insert(index->all, index->all_count, e);
+
+        int64_t day = leaderboard_day(e.unix_ms);
+        if (day > index->day) {
+            index->day = day;
+            index->day_count = 0;
+        }
+        if (day == index->day)
+            leaderboard_insert(index->today, index->day_count, e);
+
+        index->applied++;
+    }
+
+    // Dopisuje do indeksu rekordy logu od numeru index->applied.
+    bool replay(uint64_t records) {
+        LeaderboardEntry e;
+        while (index->applied < records) {
+            if (pread(log_fd, &e, sizeof(e), index->applied * sizeof(e)) != (ssize_t)sizeof(e))
+                return false;
+            apply(e);
+        }
+
+        return true;
+    }
+
+    // Po nieudanym otwarciu nie zostaje nic otwartego ani zmapowanego, więc
+    // record() i reply() zachowują się jak przy braku tablicy.
+    bool fail() {
+        if (index)
+            munmap(index, sizeof(LeaderboardIndex));
+        index = nullptr;
+
+        if (log_fd >= 0)
+            ::close(log_fd);
+        log_fd = -1;
+
+        return false;
+    }
+
+    bool open(const std::string& path) {
+        log_fd = ::open((path + ".log").c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+        if (log_fd < 0)
+            return fail();
+
+        int idx_fd = ::open((path + ".idx").c_str(), O_RDWR | O_CREAT, 0644);
+        if (idx_fd < 0)
+            return fail();
+
+        struct stat st;
+        bool fresh = fstat(idx_fd, &st) < 0 || st.st_size != (off_t)sizeof(LeaderboardIndex);
+        if (fresh && ftruncate(idx_fd, sizeof(LeaderboardIndex)) < 0) {
+            ::close(idx_fd);
+            return fail();
+        }
+
+        void* p = mmap(nullptr, sizeof(LeaderboardIndex), PROT_READ | PROT_WRITE,
+                       MAP_SHARED, idx_fd, 0);
+        ::close(idx_fd);
+        if (p == MAP_FAILED)
+            return fail();
+
+        index = static_cast<LeaderboardIndex*>(p);
+
+        if (fstat(log_fd, &st) < 0)
+            return fail();
+
+        // Niepełny ostatni rekord (przerwany zapis) jest obcinany.
+        uint64_t records = st.st_size / sizeof(LeaderboardEntry);
+        if ((uint64_t)st.st_size != records * sizeof(LeaderboardEntry) &&
+            ftruncate(log_fd, records * sizeof(LeaderboardEntry)) < 0)
+            return fail();
+
+        if (fresh || memcmp(index->magic, LEADERBOARD_MAGIC, sizeof(LEADERBOARD_MAGIC)) != 0 ||
+            index->applied > records || index->all_count > (uint32_t)LEADERBOARD_TOP ||
+            index->day_count > (uint32_t)LEADERBOARD_TOP) {
+            memset(index, 0, sizeof(LeaderboardIndex));
+            memcpy(index->magic, LEADERBOARD_MAGIC, sizeof(LEADERBOARD_MAGIC));
+        }
+
+        if (!replay(records))
+            return fail();
+
+        writer = std::thread(&Leaderboard::run, this);
+        return true;
+    }
+
+    // Wątek zapisu: wszystkie zebrane wyniki idą do logu jednym write(), a do
+    // indeksu dopiero po udanym zapisie. Niepełny zapis jest cofany, żeby
+    // log składał się tylko z całych rekordów.
+    void run() {
+        std::vector<LeaderboardEntry> batch;
+        std::unique_lock<std::mutex> lock(mutex);
+
+        while (true) {
+            wake.wait(lock, [this]() { return stopping || !pending.empty(); });
+            if (pending.empty())
+                return;
+
+            batch.swap(pending);
+            uint64_t records = index->applied;
+            lock.unlock();
+
+            ssize_t bytes = batch.size() * sizeof(LeaderboardEntry);
+            bool written = write(log_fd, batch.data(), bytes) == bytes;
+            if (!written && ftruncate(log_fd, records * sizeof(LeaderboardEntry)) < 0) {}
+
+            lock.lock();
+            if (written) {
+                for (const auto& e : batch)
+                    apply(e);
+                version++;
+            }
+            batch.clear();
+        }
+    }
+
+    void record(const std::string& name, uint32_t duration_ms, int errors) {
+        LeaderboardEntry e{};
+        e.duration_ms = duration_ms;
+        e.errors = errors;
+        e.unix_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+
+        // Obcięcie nicka bez rozcinania znaku UTF-8.
+        size_t len = std::min(name.size(), (size_t)LEADERBOARD_NAME);
+        while (len < name.size() && len > 0 && ((unsigned char)name[len] & 0xC0) == 0x80)
+            len--;
+        e.name_len = len;
+        memcpy(e.name, name.data(), len);
+
+        bool idle;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!index)
+                return;
+            idle = pending.empty();
+            pending.push_back(e);
+        }
+
+        // Niepusta kolejka znaczy, że wątek zapisu już został obudzony.
+        if (idle)
+            wake.notify_one();
+    }
+
+    // Gotowa linia odpowiedzi, budowana raz na zmianę tablicy:
+    // LEADERBOARD ALL|DAY <n> nick:czas_ms:błędy ...
+    std::shared_ptr<const std::string> reply(bool daily) {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        int64_t now_day = leaderboard_day(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+
+        if (index && daily && now_day > index->day) {
+            index->day = now_day;
+            index->day_count = 0;
+            version++;
+        }
+
+        auto& cached = replies[daily];
+        if (cached && reply_version[daily] == version)
+            return cached;
+
+        const LeaderboardEntry* top = index ? (daily ? index->today : index->all) : nullptr;
+        uint32_t count = index ? (daily ? index->day_count : index->all_count) : 0;
+
+        std::string out = daily ? "LEADERBOARD DAY " : "LEADERBOARD ALL ";
+        out += std::to_string(count);
+
+        for (uint32_t i = 0; i < count; i++) {
+            out += " ";
+            out.append(top[i].name, top[i].name_len);
+            out += ":" + std::to_string(top[i].duration_ms);
+            out += ":" + std::to_string(top[i].errors);
+        }
+
+        out += "\n";
+        cached = std::make_shared<const std::string>(std::move(out));
+        reply_version[daily] = version;
+        return cached;
+    }
+};
@@ -0,0 +1,777 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <cstring>
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <queue>
+#include <memory>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+// Generator obciążenia: boty bez interfejsu, które grają prawdziwe rundy
+// zwykłym protokołem tekstowym (NAME/CREATE/JOIN/START/GUESS/CHAT).
+//
+// Boty są dzielone na pokoje po -n graczy. Pierwszy bot pokoju tworzy go,
+// dołącza jako pierwszy (więc to on może wysyłać START) i po każdej rundzie
+// zaczyna następną. Każdy bot zgaduje litery w tempie -g na sekundę
+// (odstępy wykładnicze) i mierzy czas od wysłania GUESS do pierwszego
+// komunikatu GAME/GAME_DELTA, w którym widać jego ruch. Wynik (przepustowość
+// i percentyle opóźnień) trafia na stdout jako JSON.
+
+struct Options {
+    std::string host = "127.0.0.1";
+    int port = 5000;
+    int connections = 1000;
+    int room_size = 5;
+    double guess_rate = 2.0;
+    double chat_rate = 0.0;
+    double ramp_rate = 2000.0;
+    int duration = 30;
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    int source_addresses = 1;
+    int pause_ms = 200;
+};
+
+Options options;
+std::atomic<bool> measuring{false};
+std::atomic<bool> stopping{false};
+
+bool counting() {
+    return measuring.load(std::memory_order_relaxed);
+}
+
+uint64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+enum class Phase {
+    CONNECTING,
+    NAMING,
+    LOBBY,
+    IN_ROOM,
+    PLAYING,
+    CLOSED
+};
+
+struct Group;
+
+struct Bot {
+    int fd = -1;
+    int index;
+    Group* group;
+    bool leader;
+    std::string nick;
+    Phase phase = Phase::CONNECTING;
+    bool join_sent = false;
+
+    std::string input;
+    std::string output;
+    bool want_write = false;
+
+    // Stan bieżącej rundy.
+    uint32_t epoch = 0;
+    uint32_t tried = 0;
+    int sent = 0;
+    bool guessing = false;
+    bool waiting = false;
+    uint64_t sent_at = 0;
+};
+
+struct Group {
+    std::string room;
+    int room_id = -1;
+    int size = 0;
+    int joined = 0;
+    bool leader_joined = false;
+    Bot* leader = nullptr;
+    std::vector<Bot*> members;
+};
+
+enum TimerKind : uint8_t {
+    TIMER_GUESS,
+    TIMER_CHAT,
+    TIMER_START
+};
+
+struct Timer {
+    uint64_t at;
+    Bot* bot;
+    uint32_t epoch;
+    TimerKind kind;
+
+    bool operator>(const Timer& other) const {
+        return at > other.at;
+    }
+};
+
+struct Stats {
+    uint64_t connected = 0;
+    uint64_t connect_errors = 0;
+    uint64_t disconnects = 0;
+    uint64_t errors = 0;
+    uint64_t rounds = 0;
+    uint64_t guesses = 0;
+    uint64_t reflections = 0;
+    uint64_t timeouts = 0;
+    uint64_t chats = 0;
+    uint64_t messages_in = 0;
+    uint64_t bytes_in = 0;
+    uint64_t bytes_out = 0;
+    std::vector<uint32_t> latency_us;
+};
+
+struct Worker {
+    int id;
+    int epfd = -1;
+    int first_bot;
+    int bot_count;
+    sockaddr_in server{};
+    std::vector<std::unique_ptr<Group>> groups;
+    std::vector<std::unique_ptr<Bot>> bots;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers;
+    std::mt19937_64 rng;
+    Stats stats;
+    int opened = 0;
+    std::atomic<bool> ramp_done{false};
+    std::thread thread;
+};
+
+// Odpowiedź na GUESS, na którą czekamy dłużej, uznajemy za zgubioną.
+const uint64_t REFLECTION_TIMEOUT_NS = 5000000000ull;
+
+void send_line(Worker& w, Bot& b, const std::string& line) {
+    if (b.fd < 0)
+        return;
+
+    if (counting())
+        w.stats.bytes_out += line.size();
+
+    if (b.output.empty()) {
+        ssize_t n = send(b.fd, line.data(), line.size(), MSG_NOSIGNAL);
+        if (n == (ssize_t)line.size())
+            return;
+        if (n < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                return;
+            n = 0;
+        }
+        b.output.append(line, n, std::string::npos);
+    } else {
+        b.output += line;
+    }
+
+    if (!b.want_write) {
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLOUT;
+        ev.data.ptr = &b;
+        epoll_ctl(w.epfd, EPOLL_CTL_MOD, b.fd, &ev);
+        b.want_write = true;
+    }
+}
+
+void flush_bot(Worker& w, Bot& b) {
+    while (!b.output.empty()) {
+        ssize_t n = send(b.fd, b.output.data(), b.output.size(), MSG_NOSIGNAL);
+        if (n <= 0)
+            break;
+        b.output.erase(0, n);
+    }
+
+    if (b.output.empty() && b.want_write) {
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.ptr = &b;
+        epoll_ctl(w.epfd, EPOLL_CTL_MOD, b.fd, &ev);
+        b.want_write = false;
+    }
+}
+
+uint64_t next_interval(Worker& w, double rate) {
+    std::exponential_distribution<double> dist(rate);
+    return (uint64_t)(dist(w.rng) * 1e9);
+}
+
+void schedule(Worker& w, Bot& b, TimerKind kind, uint64_t delay) {
+    w.timers.push(Timer{now_ns() + delay, &b, b.epoch, kind});
+}
+
+void close_bot(Worker& w, Bot& b) {
+    if (b.fd < 0)
+        return;
+
+    epoll_ctl(w.epfd, EPOLL_CTL_DEL, b.fd, nullptr);
+    close(b.fd);
+    b.fd = -1;
+    b.phase = Phase::CLOSED;
+}
+
+void open_bot(Worker& w, Bot& b) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (fd < 0) {
+        w.stats.connect_errors++;
+        return;
+    }
+
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    // Przy wielu dziesiątkach tysięcy połączeń do jednego adresu kończą się
+    // porty źródłowe; na loopbacku można je rozłożyć na kilka adresów 127.0.0.x.
+    if (options.source_addresses > 1) {
+        sockaddr_in local{};
+        local.sin_family = AF_INET;
+        local.sin_addr.s_addr = htonl(0x7F000001 + b.index % options.source_addresses);
+        bind(fd, (sockaddr*)&local, sizeof(local));
+    }
+
+    if (connect(fd, (sockaddr*)&w.server, sizeof(w.server)) < 0 && errno != EINPROGRESS) {
+        close(fd);
+        w.stats.connect_errors++;
+        return;
+    }
+
+    b.fd = fd;
+    b.phase = Phase::CONNECTING;
+    b.want_write = true;
+
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLOUT;
+    ev.data.ptr = &b;
+    epoll_ctl(w.epfd, EPOLL_CTL_ADD, fd, &ev);
+}
+
+void on_connected(Worker& w, Bot& b) {
+    int err = 0;
+    socklen_t len = sizeof(err);
+    getsockopt(b.fd, SOL_SOCKET, SO_ERROR, &err, &len);
+
+    if (err != 0) {
+        w.stats.connect_errors++;
+        close_bot(w, b);
+        return;
+    }
+
+    w.stats.connected++;
+    b.phase = Phase::NAMING;
+    send_line(w, b, "NAME " + b.nick + "\nDELTA ON\n");
+}
+
+void send_guess(Worker& w, Bot& b) {
+    if (!b.guessing || b.waiting || b.phase != Phase::PLAYING)
+        return;
+
+    uint32_t left = ~b.tried & ((1u << 26) - 1);
+    if (!left)
+        return;
+
+    int pick = std::uniform_int_distribution<int>(0, __builtin_popcount(left) - 1)(w.rng);
+    int letter = 0;
+    for (uint32_t rest = left; ; rest &= rest - 1) {
+        if (pick-- == 0) {
+            letter = __builtin_ctz(rest);
+            break;
+        }
+    }
+
+    b.tried |= 1u << letter;
+    b.sent++;
+    b.waiting = true;
+    b.sent_at = now_ns();
+
+    std::string line = "GUESS ";
+    line += (char)('A' + letter);
+    line += "\n";
+    send_line(w, b, line);
+
+    if (counting())
+        w.stats.guesses++;
+}
+
+void reflected(Worker& w, Bot& b) {
+    if (!b.waiting)
+        return;
+
+    b.waiting = false;
+
+    if (counting()) {
+        w.stats.reflections++;
+        w.stats.latency_us.push_back((uint32_t)((now_ns() - b.sent_at) / 1000));
+    }
+
+    if (b.guessing)
+        schedule(w, b, TIMER_GUESS, next_interval(w, options.guess_rate));
+}
+
+void maybe_start(Worker& w, Group& g) {
+    if (g.joined == g.size && g.leader->phase == Phase::IN_ROOM)
+        schedule(w, *g.leader, TIMER_START, 0);
+}
+
+void round_started(Worker& w, Bot& b) {
+    b.phase = Phase::PLAYING;
+    b.epoch++;
+    b.tried = 0;
+    b.sent = 0;
+    b.guessing = true;
+    b.waiting = false;
+
+    schedule(w, b, TIMER_GUESS, next_interval(w, options.guess_rate));
+    if (options.chat_rate > 0)
+        schedule(w, b, TIMER_CHAT, next_interval(w, options.chat_rate));
+}
+
+// Wpis bota w pełnym GAME: nick:etap:odgadnięte:błędne:aktywny:zgadł:postęp.
+// Ruch jest widoczny, gdy liczba liter w błędnych i odkrytych dogoniła
+// liczbę wysłanych zgadnięć.
+void on_game(Worker& w, Bot& b, std::string_view line) {
+    if (b.phase != Phase::PLAYING) {
+        round_started(w, b);
+        return;
+    }
+
+    std::string key = " " + b.nick + ":";
+    size_t pos = line.find(key);
+    if (pos == std::string_view::npos)
+        return;
+
+    std::string_view entry = line.substr(pos + key.size());
+    entry = entry.substr(0, entry.find(' '));
+
+    std::string_view fields[6];
+    for (int i = 0; i < 6; i++) {
+        size_t colon = entry.find(':');
+        fields[i] = entry.substr(0, colon);
+        entry = colon == std::string_view::npos ? std::string_view() : entry.substr(colon + 1);
+    }
+
+    uint32_t seen = 0;
+    for (char ch : fields[2])
+        seen |= 1u << (ch - 'A');
+    for (char ch : fields[5])
+        if (ch != '_')
+            seen |= 1u << (ch - 'A');
+
+    if (fields[3] != "1" || fields[4] == "1")
+        b.guessing = false;
+
+    if (b.waiting && __builtin_popcount(seen) >= b.sent)
+        reflected(w, b);
+}
+
+// GAME_DELTA <nick> s=.. g=.. w=.. a=.. d=.. p=..; przy jednym GUESS w locie
+// każda delta z naszym nickiem jest odpowiedzią na ostatni ruch.
+void on_game_delta(Worker& w, Bot& b, std::string_view line) {
+    std::string_view rest = line.substr(strlen("GAME_DELTA "));
+    if (rest.substr(0, rest.find(' ')) != b.nick || b.phase != Phase::PLAYING)
+        return;
+
+    if (rest.find(" a=0") != std::string_view::npos || rest.find(" d=1") != std::string_view::npos)
+        b.guessing = false;
+
+    reflected(w, b);
+}
+
+void join_room(Worker& w, Bot& b) {
+    if (b.phase != Phase::LOBBY || b.join_sent || b.group->room_id < 0)
+        return;
+
+    b.join_sent = true;
+    send_line(w, b, "JOIN " + std::to_string(b.group->room_id) + "\n");
+}
+
+// Identyfikator pokoju zna tylko lista ROOMS (nazwa:gracze:gra:id), więc
+// odczytuje go lider; pozostali dołączają dopiero po nim, żeby to lider był
+// najdłużej w pokoju i mógł wysyłać START.
+void on_rooms(Worker& w, Bot& b, std::string_view line) {
+    Group& g = *b.group;
+    if (!b.leader || g.room_id >= 0)
+        return;
+
+    std::string key = " " + g.room + ":";
+    size_t pos = line.find(key);
+    if (pos == std::string_view::npos)
+        return;
+
+    std::string_view entry = line.substr(pos + key.size());
+    entry = entry.substr(0, entry.find(' '));
+    size_t last = entry.rfind(':');
+    g.room_id = atoi(std::string(entry.substr(last + 1)).c_str());
+
+    join_room(w, b);
+}
+
+void on_line(Worker& w, Bot& b, std::string_view line) {
+    if (counting())
+        w.stats.messages_in++;
+    Group& g = *b.group;
+
+    if (line.compare(0, 11, "GAME_DELTA ") == 0) {
+        on_game_delta(w, b, line);
+    }
+    else if (line.compare(0, 5, "GAME ") == 0) {
+        on_game(w, b, line);
+    }
+    else if (line.compare(0, 6, "ROOMS ") == 0) {
+        on_rooms(w, b, line);
+    }
+    else if (line.compare(0, 10, "ROOM_LOBBY") == 0) {
+        b.phase = Phase::IN_ROOM;
+        b.guessing = false;
+        b.waiting = false;
+        b.epoch++;
+
+        if (b.leader) {
+            if (counting())
+                w.stats.rounds++;
+            schedule(w, b, TIMER_START, options.pause_ms * 1000000ull);
+        }
+    }
+    else if (line.compare(0, 7, "JOINED ") == 0) {
+        b.phase = Phase::IN_ROOM;
+        g.joined++;
+        if (b.leader) {
+            g.leader_joined = true;
+            for (Bot* m : g.members)
+                join_room(w, *m);
+        }
+        maybe_start(w, g);
+    }
+    else if (line.compare(0, 3, "OK ") == 0) {
+        if (b.phase == Phase::NAMING) {
+            b.phase = Phase::LOBBY;
+            if (b.leader)
+                send_line(w, b, "CREATE " + g.room + "\n");
+            else if (g.leader_joined)
+                join_room(w, b);
+        }
+    }
+    else if (line.compare(0, 7, "WAITING") == 0) {
+        b.join_sent = false;
+    }
+    else if (line.compare(0, 6, "ERROR ") == 0) {
+        w.stats.errors++;
+    }
+}
+
+void read_bot(Worker& w, Bot& b) {
+    char buf[16384];
+
+    while (b.fd >= 0) {
+        ssize_t n = recv(b.fd, buf, sizeof(buf), 0);
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            w.stats.disconnects++;
+            close_bot(w, b);
+            return;
+        }
+        if (n < 0)
+            return;
+
+        if (counting())
+            w.stats.bytes_in += n;
+        b.input.append(buf, n);
+
+        size_t start = 0;
+        size_t end;
+        while ((end = b.input.find('\n', start)) != std::string::npos) {
+            std::string_view line(b.input.data() + start, end - start);
+            if (!line.empty() && line.back() == '\r')
+                line.remove_suffix(1);
+            on_line(w, b, line);
+            start = end + 1;
+        }
+        b.input.erase(0, start);
+    }
+}
+
+void fire(Worker& w, const Timer& t) {
+    Bot& b = *t.bot;
+    if (b.fd < 0 || t.epoch != b.epoch)
+        return;
+
+    switch (t.kind) {
+    case TIMER_GUESS:
+        send_guess(w, b);
+        break;
+    case TIMER_CHAT:
+        if (b.phase == Phase::PLAYING) {
+            send_line(w, b, "CHAT gl hf\n");
+            if (counting())
+                w.stats.chats++;
+            schedule(w, b, TIMER_CHAT, next_interval(w, options.chat_rate));
+        }
+        break;
+    case TIMER_START:
+        if (b.phase == Phase::IN_ROOM)
+            send_line(w, b, "START\n");
+        break;
+    }
+}
+
+void check_timeouts(Worker& w, uint64_t now) {
+    for (auto& b : w.bots) {
+        if (b->waiting && now - b->sent_at > REFLECTION_TIMEOUT_NS) {
+            b->waiting = false;
+            if (counting())
+                w.stats.timeouts++;
+            if (b->guessing)
+                schedule(w, *b, TIMER_GUESS, next_interval(w, options.guess_rate));
+        }
+    }
+}
+
+void worker_loop(Worker& w) {
+    double rate = options.ramp_rate / options.threads;
+    uint64_t started = now_ns();
+    uint64_t last_timeout_check = started;
+    epoll_event events[256];
+
+    while (!stopping.load(std::memory_order_relaxed)) {
+        uint64_t now = now_ns();
+
+        // Otwieranie kolejnych połączeń z zadanym tempem.
+        if (w.opened < w.bot_count) {
+            int due = std::min<int>(w.bot_count, (int)((now - started) / 1e9 * rate) + 1);
+            while (w.opened < due)
+                open_bot(w, *w.bots[w.opened++]);
+            if (w.opened == w.bot_count)
+                w.ramp_done.store(true);
+        }
+
+        while (!w.timers.empty() && w.timers.top().at <= now) {
+            Timer t = w.timers.top();
+            w.timers.pop();
+            fire(w, t);
+        }
+
+        if (now - last_timeout_check > 1000000000ull) {
+            check_timeouts(w, now);
+            last_timeout_check = now;
+        }
+
+        int timeout = 1;
+        if (w.opened == w.bot_count && !w.timers.empty()) {
+            uint64_t wait = (w.timers.top().at - std::min(w.timers.top().at, now_ns())) / 1000000;
+            timeout = (int)std::min<uint64_t>(wait, 10);
+        }
+
+        int n = epoll_wait(w.epfd, events, 256, timeout);
+        for (int i = 0; i < n; i++) {
+            Bot& b = *static_cast<Bot*>(events[i].data.ptr);
+            if (b.fd < 0)
+                continue;
+
+            if (b.phase == Phase::CONNECTING) {
+                if (events[i].events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) {
+                    on_connected(w, b);
+                    if (b.fd >= 0)
+                        flush_bot(w, b);
+                }
+                continue;
+            }
+
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+                read_bot(w, b);
+
+            if (b.fd >= 0 && (events[i].events & EPOLLOUT))
+                flush_bot(w, b);
+        }
+    }
+
+    for (auto& b : w.bots) {
+        if (b->fd >= 0)
+            close(b->fd);
+    }
+}
+
+uint32_t percentile(const std::vector<uint32_t>& sorted, double p) {
+    if (sorted.empty())
+        return 0;
+    size_t i = std::min(sorted.size() - 1, (size_t)(p * sorted.size()));
+    return sorted[i];
+}
+
+void usage(const char* prog) {
+    std::cerr << "Użycie: " << prog << " [-h host] [-p port] [-c połączenia] [-n graczy_w_pokoju]"
+              << " [-g zgadnięć_na_s] [-m czatów_na_s] [-r połączeń_na_s] [-t czas_s]"
+              << " [-w wątki] [-s adresy_źródłowe] [-z przerwa_ms]" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    int opt;
+    while ((opt = getopt(argc, argv, "h:p:c:n:g:m:r:t:w:s:z:")) != -1) {
+        switch (opt) {
+        case 'h': options.host = optarg; break;
+        case 'p': options.port = atoi(optarg); break;
+        case 'c': options.connections = atoi(optarg); break;
+        case 'n': options.room_size = atoi(optarg); break;
+        case 'g': options.guess_rate = atof(optarg); break;
+        case 'm': options.chat_rate = atof(optarg); break;
+        case 'r': options.ramp_rate = atof(optarg); break;
+        case 't': options.duration = atoi(optarg); break;
+        case 'w': options.threads = atoi(optarg); break;
+        case 's': options.source_addresses = atoi(optarg); break;
+        case 'z': options.pause_ms = atoi(optarg); break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (options.room_size < 2 || options.room_size > 5 || options.connections < options.room_size ||
+        options.guess_rate <= 0 || options.ramp_rate <= 0 || options.threads < 1) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* resolved = nullptr;
+    if (getaddrinfo(options.host.c_str(), nullptr, &hints, &resolved) != 0 || !resolved) {
+        std::cerr << "Nieznany host " << options.host << std::endl;
+        return 1;
+    }
+    sockaddr_in server = *(sockaddr_in*)resolved->ai_addr;
+    server.sin_port = htons(options.port);
+    freeaddrinfo(resolved);
+
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    // Pokoje nie są dzielone między wątki, więc stan pokoju (kto dołączył,
+    // kiedy startować) jest zwykłą strukturą jednego wątku.
+    int groups = options.connections / options.room_size;
+    options.threads = std::min(options.threads, groups);
+    std::string prefix = "lg" + std::to_string(getpid()) + "_";
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    int next_group = 0;
+    for (int i = 0; i < options.threads; i++) {
+        auto w = std::make_unique<Worker>();
+        w->id = i;
+        w->server = server;
+        w->rng.seed(std::random_device{}() + i);
+        w->epfd = epoll_create1(0);
+
+        int count = groups / options.threads + (i < groups % options.threads ? 1 : 0);
+        w->first_bot = next_group * options.room_size;
+        w->bot_count = count * options.room_size;
+
+        for (int gi = 0; gi < count; gi++, next_group++) {
+            auto g = std::make_unique<Group>();
+            g->room = prefix + "r" + std::to_string(next_group);
+            g->size = options.room_size;
+
+            for (int k = 0; k < options.room_size; k++) {
+                auto b = std::make_unique<Bot>();
+                b->index = next_group * options.room_size + k;
+                b->group = g.get();
+                b->leader = k == 0;
+                b->nick = prefix + std::to_string(b->index);
+                if (b->leader)
+                    g->leader = b.get();
+                else
+                    g->members.push_back(b.get());
+                w->bots.push_back(std::move(b));
+            }
+
+            w->groups.push_back(std::move(g));
+        }
+
+        workers.push_back(std::move(w));
+    }
+
+    for (auto& w : workers) {
+        Worker* wp = w.get();
+        w->thread = std::thread([wp]() { worker_loop(*wp); });
+    }
+
+    uint64_t begin = now_ns();
+    while (true) {
+        bool done = true;
+        for (auto& w : workers)
+            done = done && w->ramp_done.load();
+        if (done)
+            break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    uint64_t ramp_ns = now_ns() - begin;
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+
+    measuring.store(true);
+    uint64_t measure_start = now_ns();
+    std::this_thread::sleep_for(std::chrono::seconds(options.duration));
+    measuring.store(false);
+    double seconds = (now_ns() - measure_start) / 1e9;
+
+    stopping.store(true);
+    for (auto& w : workers)
+        w->thread.join();
+
+    Stats total;
+    for (auto& w : workers) {
+        Stats& s = w->stats;
+        total.connected += s.connected;
+        total.connect_errors += s.connect_errors;
+        total.disconnects += s.disconnects;
+        total.errors += s.errors;
+        total.rounds += s.rounds;
+        total.guesses += s.guesses;
+        total.reflections += s.reflections;
+        total.timeouts += s.timeouts;
+        total.chats += s.chats;
+        total.messages_in += s.messages_in;
+        total.bytes_in += s.bytes_in;
+        total.bytes_out += s.bytes_out;
+        total.latency_us.insert(total.latency_us.end(), s.latency_us.begin(), s.latency_us.end());
+        close(w->epfd);
+    }
+
+    std::vector<uint32_t>& lat = total.latency_us;
+    std::sort(lat.begin(), lat.end());
+
+    std::cout << "{\n"
+              << "  \"connections\": " << groups * options.room_size << ",\n"
+              << "  \"connected\": " << total.connected << ",\n"
+              << "  \"connect_errors\": " << total.connect_errors << ",\n"
+              << "  \"disconnects\": " << total.disconnects << ",\n"
+              << "  \"server_errors\": " << total.errors << ",\n"
+              << "  \"ramp_s\": " << ramp_ns / 1e9 << ",\n"
+              << "  \"duration_s\": " << seconds << ",\n"
+              << "  \"rounds\": " << total.rounds << ",\n"
+              << "  \"guesses\": " << total.guesses << ",\n"
+              << "  \"guesses_per_s\": " << total.guesses / seconds << ",\n"
+              << "  \"chats\": " << total.chats << ",\n"
+              << "  \"messages_in_per_s\": " << total.messages_in / seconds << ",\n"
+              << "  \"bytes_in_per_s\": " << total.bytes_in / seconds << ",\n"
+              << "  \"bytes_out_per_s\": " << total.bytes_out / seconds << ",\n"
+              << "  \"reflection_timeouts\": " << total.timeouts << ",\n"
+              << "  \"guess_to_game_us\": {\n"
+              << "    \"samples\": " << lat.size() << ",\n"
+              << "    \"p50\": " << percentile(lat, 0.50) << ",\n"
+              << "    \"p99\": " << percentile(lat, 0.99) << ",\n"
+              << "    \"p999\": " << percentile(lat, 0.999) << ",\n"
+              << "    \"max\": " << (lat.empty() ? 0 : lat.back()) << "\n"
+              << "  }\n"
+              << "}" << std::endl;
+
+    return 0;
+}
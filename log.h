@@ -0,0 +1,278 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <charconv>
+#include <type_traits>
+#include <ctime>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+// Asynchroniczny logger. Wątki serwera tylko formatują linię do wolnego
+// slotu pierścienia (bez blokad; wywołanie systemowe jest potrzebne tylko do
+// obudzenia bezczynnego wątku zapisu); zapisem na stdout/stderr zajmuje się
+// osobny wątek. Gdy pierścień jest pełny, linia jest odrzucana, a liczba
+// odrzuconych trafia do logu przy następnym zapisie.
+//
+// Format: <czas UTC> <poziom> <komunikat> klucz=wartość ...
+//   LOG_INFO("Rozpoczęto grę", "room", room->name, "word", room->secret_word);
+//
+// Poziomy poniżej LOG_LEVEL (domyślnie INFO) znikają już przy kompilacji,
+// razem z wyliczaniem argumentów: -DLOG_LEVEL=0 włącza DEBUG.
+
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_ERROR 3
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+struct LogSlot {
+    static const size_t TEXT = 480;
+
+    std::atomic<uint64_t> sequence{0};
+    int64_t timestamp_ns;
+    uint8_t level;
+    uint16_t length;
+    char text[TEXT];
+};
+
+struct Logger {
+    static const size_t SLOTS = 4096;
+
+    LogSlot ring[SLOTS];
+    std::atomic<uint64_t> tail{0};
+    uint64_t head = 0;
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<bool> started{false};
+    std::atomic<bool> sleeping{false};
+    int wake_fd = eventfd(0, 0);
+
+    Logger() {
+        for (size_t i = 0; i < SLOTS; i++)
+            ring[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    // Rezerwuje slot (kolejka Vyukova z wieloma producentami); nullptr, gdy
+    // pierścień jest pełny.
+    LogSlot* claim() {
+        uint64_t pos = tail.load(std::memory_order_relaxed);
+
+        while (true) {
+            LogSlot& slot = ring[pos & (SLOTS - 1)];
+            uint64_t seq = slot.sequence.load(std::memory_order_acquire);
+            int64_t diff = (int64_t)seq - (int64_t)pos;
+
+            if (diff == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    return &slot;
+            } else if (diff < 0) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            } else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Wątek zapisu, który nie ma nic do roboty, śpi na eventfd; budzi go
+    // dopiero pierwsza nowa linia. Zapis i odczyt w porządku seq_cst po obu
+    // stronach gwarantują, że albo wątek zapisu zobaczy nową linię, albo
+    // producent zobaczy sleeping.
+    void publish(LogSlot* slot) {
+        uint64_t pos = slot->sequence.load(std::memory_order_relaxed);
+        slot->sequence.store(pos + 1);
+
+        if (sleeping.load() && sleeping.exchange(false)) {
+            uint64_t one = 1;
+            if (write(wake_fd, &one, sizeof(one)) < 0) {}
+        }
+    }
+
+    void wait() {
+        sleeping.store(true);
+
+        if (ring[head & (SLOTS - 1)].sequence.load() == head + 1) {
+            sleeping.store(false);
+            return;
+        }
+
+        uint64_t count;
+        if (read(wake_fd, &count, sizeof(count)) < 0) {}
+    }
+
+    static void append_time(std::string& out, int64_t ns) {
+        time_t sec = ns / 1000000000;
+        struct tm tm;
+        gmtime_r(&sec, &tm);
+
+        char buf[40];
+        size_t n = strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%S", &tm);
+        n += snprintf(buf + n, sizeof(buf) - n, ".%03dZ", (int)(ns / 1000000 % 1000));
+        out.append(buf, n);
+    }
+
+    static const char* level_name(int level) {
+        static const char* names[] = {"DEBUG", "INFO", "WARN", "ERROR"};
+        return names[level];
+    }
+
+    // Przenosi gotowe linie do buforów; zwraca false, gdy nie było nic nowego.
+    bool drain(std::string& out, std::string& err) {
+        bool any = false;
+
+        uint64_t lost = dropped.exchange(0, std::memory_order_relaxed);
+        if (lost) {
+            err += "WARN Logger odrzucił linie: " + std::to_string(lost) + "\n";
+            any = true;
+        }
+
+        while (true) {
+            LogSlot& slot = ring[head & (SLOTS - 1)];
+            if (slot.sequence.load(std::memory_order_acquire) != head + 1)
+                break;
+
+            std::string& dst = slot.level >= LOG_LEVEL_WARN ? err : out;
+            append_time(dst, slot.timestamp_ns);
+            dst += ' ';
+            dst += level_name(slot.level);
+            dst += ' ';
+            dst.append(slot.text, slot.length);
+            dst += '\n';
+
+            slot.sequence.store(head + SLOTS, std::memory_order_release);
+            head++;
+            any = true;
+        }
+
+        return any;
+    }
+
+    static void write_all(int fd, std::string& buf) {
+        size_t done = 0;
+        while (done < buf.size()) {
+            ssize_t n = write(fd, buf.data() + done, buf.size() - done);
+            if (n <= 0)
+                break;
+            done += n;
+        }
+        buf.clear();
+    }
+
+    void run() {
+        std::string out, err;
+
+        while (true) {
+            if (!drain(out, err)) {
+                wait();
+                continue;
+            }
+
+            write_all(STDOUT_FILENO, out);
+            write_all(STDERR_FILENO, err);
+
+            // Krótka przerwa zbiera kolejne linie w jeden zapis.
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+
+    void start() {
+        if (!started.exchange(true))
+            std::thread(&Logger::run, this).detach();
+    }
+};
+
+inline Logger& logger() {
+    static Logger* instance = new Logger();
+    return *instance;
+}
+
+// Składanie linii w slocie; nadmiar jest obcinany.
+struct LogLine {
+    LogSlot* slot;
+
+    void append(std::string_view s) {
+        size_t room = LogSlot::TEXT - slot->length;
+        size_t n = s.size() < room ? s.size() : room;
+        memcpy(slot->text + slot->length, s.data(), n);
+        slot->length += n;
+    }
+
+    void value(std::string_view s) {
+        bool quote = s.empty() || s.find_first_of(" =\"") != std::string_view::npos;
+        if (quote)
+            append("\"");
+        append(s);
+        if (quote)
+            append("\"");
+    }
+
+    void value(const std::string& s) { value(std::string_view(s)); }
+    void value(const char* s) { value(std::string_view(s)); }
+    void value(char ch) { append(std::string_view(&ch, 1)); }
+    void value(bool b) { append(b ? "1" : "0"); }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value>::type value(T v) {
+        char buf[24];
+        auto res = std::to_chars(buf, buf + sizeof(buf), v);
+        append(std::string_view(buf, res.ptr - buf));
+    }
+
+    void fields() {}
+
+    template <typename V, typename... Rest>
+    void fields(std::string_view key, const V& v, const Rest&... rest) {
+        append(" ");
+        append(key);
+        append("=");
+        value(v);
+        fields(rest...);
+    }
+};
+
+template <typename... Fields>
+void log_write(int level, std::string_view message, const Fields&... fields) {
+    LogSlot* slot = logger().claim();
+    if (!slot)
+        return;
+
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+    slot->timestamp_ns = (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+    slot->level = level;
+    slot->length = 0;
+
+    LogLine line{slot};
+    line.append(message);
+    line.fields(fields...);
+
+    logger().publish(slot);
+}
+
+#if LOG_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) log_write(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) ((void)0)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(...) log_write(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) ((void)0)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_WARN
+#define LOG_WARN(...) log_write(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...) ((void)0)
+#endif
+
+#define LOG_ERROR(...) log_write(LOG_LEVEL_ERROR, __VA_ARGS__)
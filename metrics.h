@@ -0,0 +1,171 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <string>
+#include <atomic>
+#include <functional>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+// Liczniki i histogramy w formacie Prometheusa.
+//
+// Każdy reaktor ma własny komplet liczników i tylko on je zmienia, więc
+// zapis to zwykłe load + store bez instrukcji z blokadą magistrali. Wątek
+// eksportu czyta je bez zatrzymywania reaktorów i sumuje przy odpowiedzi.
+// Histogramy mają przedziały będące potęgami dwójki, więc wybór przedziału
+// to jedno liczenie bitów zamiast przeszukiwania granic.
+
+struct Counter {
+    std::atomic<uint64_t> value{0};
+
+    void add(uint64_t n = 1) {
+        value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    uint64_t get() const {
+        return value.load(std::memory_order_relaxed);
+    }
+};
+
+// Górne granice przedziałów: 2^FIRST, 2^(FIRST+1), ..., ostatni to +Inf.
+template <int FIRST, int BOUNDS>
+struct Histogram {
+    static const int BUCKETS = BOUNDS + 1;
+
+    Counter buckets[BUCKETS];
+    Counter count;
+    Counter sum;
+
+    static int bucket_for(uint64_t v) {
+        int bits = v <= 1 ? 0 : 64 - __builtin_clzll(v - 1);
+        int b = bits - FIRST;
+        return b < 0 ? 0 : b > BOUNDS ? BOUNDS : b;
+    }
+
+    void observe(uint64_t v) {
+        buckets[bucket_for(v)].add();
+        count.add();
+        sum.add(v);
+    }
+};
+
+// Suma histogramów z kilku reaktorów, gotowa do wypisania.
+template <int FIRST, int BOUNDS>
+struct HistogramTotal {
+    uint64_t buckets[BOUNDS + 1] = {};
+    uint64_t count = 0;
+    uint64_t sum = 0;
+
+    void merge(const Histogram<FIRST, BOUNDS>& h) {
+        for (int i = 0; i <= BOUNDS; i++)
+            buckets[i] += h.buckets[i].get();
+        count += h.count.get();
+        sum += h.sum.get();
+    }
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    // scale przelicza jednostkę pomiaru na jednostkę eksportu (ns -> s).
+    void write(std::string& out, const char* name, const std::string& labels,
+               double scale) const {
+        std::string sep = labels.empty() ? "" : labels + ",";
+        uint64_t cumulative = 0;
+        char le[32];
+
+        for (int i = 0; i < BOUNDS; i++) {
+            cumulative += buckets[i];
+            snprintf(le, sizeof(le), "%g", (double)(1ull << (FIRST + i)) * scale);
+            out += std::string(name) + "_bucket{" + sep + "le=\"" + le + "\"} " +
+                   std::to_string(cumulative) + "\n";
+        }
+
+        out += std::string(name) + "_bucket{" + sep + "le=\"+Inf\"} " +
+               std::to_string(count) + "\n";
+
+        char total[32];
+        snprintf(total, sizeof(total), "%.9g", (double)sum * scale);
+        std::string braces = labels.empty() ? "" : "{" + labels + "}";
+        out += std::string(name) + "_sum" + braces + " " + total + "\n";
+        out += std::string(name) + "_count" + braces + " " + std::to_string(count) + "\n";
+    }
+};
+
+inline void metric_header(std::string& out, const char* name, const char* type,
+                          const char* help) {
+    out += std::string("# HELP ") + name + " " + help + "\n";
+    out += std::string("# TYPE ") + name + " " + type + "\n";
+}
+
+inline void write_metric(std::string& out, const char* name, const char* type,
+                         const char* help, uint64_t value) {
+    metric_header(out, name, type, help);
+    out += std::string(name) + " " + std::to_string(value) + "\n";
+}
+
+// Gniazdo eksportu na 127.0.0.1:port; -1 przy błędzie.
+inline int open_metrics_socket(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+
+    int opt = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, 16) < 0) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+// Prosty serwer HTTP dla Prometheusa. Każde połączenie dostaje aktualny stan
+// z render() niezależnie od ścieżki i jest zamykane.
+inline void serve_metrics(int fd, std::function<std::string()> render) {
+    while (true) {
+        int cfd = accept(fd, nullptr, nullptr);
+        if (cfd < 0)
+            continue;
+
+        timeval timeout{1, 0};
+        setsockopt(cfd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        // Wystarczy doczytać nagłówki zapytania; treść odpowiedzi jest zawsze ta sama.
+        std::string request;
+        char buf[1024];
+        while (request.find("\r\n\r\n") == std::string::npos && request.size() < 8192) {
+            ssize_t n = recv(cfd, buf, sizeof(buf), 0);
+            if (n <= 0)
+                break;
+            request.append(buf, n);
+        }
+
+        std::string body = render();
+        std::string response =
+            "HTTP/1.1 200 OK\r\n"
+            "Content-Type: text/plain; version=0.0.4\r\n"
+            "Content-Length: " + std::to_string(body.size()) + "\r\n"
+            "Connection: close\r\n\r\n" + body;
+
+        size_t done = 0;
+        while (done < response.size()) {
+            ssize_t n = send(cfd, response.data() + done, response.size() - done, MSG_NOSIGNAL);
+            if (n <= 0)
+                break;
+            done += n;
+        }
+
+        close(cfd);
+    }
+}
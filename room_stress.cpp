@@ -0,0 +1,337 @@
+// Test obciążeniowy rejestru pokoi i lobby: serwer z kilkoma reaktorami
+// działa w tym samym procesie, a każda para klientów w osobnym wątku tworzy
+// własny pokój i rozgrywa w nim kilka rund (JOIN, START, GUESS, LEAVE),
+// podczas gdy lista ROOMS zmienia się pod wpływem wszystkich pozostałych.
+// Potem sprawdza, że odmowa JOIN do pełnego pokoju i do pokoju w trakcie
+// rundy na innym reaktorze zostawia gracza w jego pokoju. Na końcu sprawdza,
+// że każda runda się odbyła, wszystkie połączenia zostały zamknięte, a pokoje
+// są puste. Przeznaczony do uruchamiania także w buildzie
+// z -fsanitize=thread.
+//
+// Użycie: ./room_stress [-r reaktory] [-n pokoje] [-k rundy] [-p port]
+
+#define SERVER_NO_MAIN
+#include "server.cpp"
+
+#include <poll.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+const int STRESS_TIMEOUT_MS = 30000;
+
+struct StressOptions {
+    int reactors = 4;
+    int rooms = 300;
+    int rounds = 3;
+    int port = 5100;
+};
+
+StressOptions stress;
+std::atomic<int> rounds_played{0};
+std::atomic<int> failures{0};
+
+// Blokujące połączenie testowe czytające linie protokołu.
+struct TestClient {
+    int fd = -1;
+    std::string buf;
+
+    bool connect_to(int port, const std::string& nick) {
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        if (fd < 0 || connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0)
+            return false;
+
+        return send_line("NAME " + nick) && wait_for({"OK"}).size() > 0;
+    }
+
+    bool send_line(const std::string& line) {
+        std::string out = line + "\n";
+        return send(fd, out.data(), out.size(), MSG_NOSIGNAL) == (ssize_t)out.size();
+    }
+
+    // Pierwsza linia zaczynająca się od jednego z przedrostków; pozostałe
+    // (np. rozgłaszane ROOMS) są pomijane. Pusty napis po przekroczeniu czasu.
+    std::string wait_for(std::initializer_list<const char*> prefixes) {
+        auto deadline = std::chrono::steady_clock::now() +
+                        std::chrono::milliseconds(STRESS_TIMEOUT_MS);
+
+        while (true) {
+            size_t nl;
+            while ((nl = buf.find('\n')) != std::string::npos) {
+                std::string line = buf.substr(0, nl);
+                buf.erase(0, nl + 1);
+
+                for (const char* p : prefixes)
+                    if (line.compare(0, strlen(p), p) == 0)
+                        return line;
+            }
+
+            int left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now()).count();
+            pollfd pfd{fd, POLLIN, 0};
+            if (left <= 0 || poll(&pfd, 1, left) <= 0)
+                return "";
+
+            char chunk[65536];
+            ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+            if (n <= 0)
+                return "";
+            buf.append(chunk, n);
+        }
+    }
+
+    // Id pokoju o podanej nazwie z kolejnych list ROOMS; -1 po czasie.
+    int wait_for_room(const std::string& room_name) {
+        std::string key = " " + room_name + ":";
+
+        while (true) {
+            std::string line = wait_for({"ROOMS"});
+            if (line.empty())
+                return -1;
+
+            size_t pos = line.find(key);
+            if (pos == std::string::npos)
+                continue;
+
+            size_t end = line.find(' ', pos + 1);
+            std::string entry = line.substr(pos + 1, end == std::string::npos ? end : end - pos - 1);
+            return atoi(entry.substr(entry.rfind(':') + 1).c_str());
+        }
+    }
+};
+
+void fail(int pair, const char* step) {
+    fprintf(stderr, "para %d: %s\n", pair, step);
+    failures.fetch_add(1);
+}
+
+void play_pair(int pair) {
+    TestClient a, b;
+    std::string room_name = "stress" + std::to_string(pair);
+
+    if (!a.connect_to(stress.port, "sa" + std::to_string(pair)) ||
+        !b.connect_to(stress.port, "sb" + std::to_string(pair)))
+        return fail(pair, "NAME");
+
+    a.send_line("CREATE " + room_name);
+    int id = a.wait_for_room(room_name);
+    if (id < 0)
+        return fail(pair, "CREATE");
+
+    std::mt19937 gen(pair);
+
+    for (int round = 0; round < stress.rounds; round++) {
+        for (TestClient* c : {&a, &b}) {
+            // WAITING: poprzednia runda jeszcze trwa, bo nikt jej nie skończył.
+            while (true) {
+                c->send_line("JOIN " + std::to_string(id));
+                std::string reply = c->wait_for({"JOINED", "WAITING", "ERROR"});
+                if (reply.compare(0, 6, "JOINED") == 0)
+                    break;
+                if (reply.empty() || reply.compare(0, 5, "ERROR") == 0)
+                    return fail(pair, "JOIN");
+
+                c->send_line("LEAVE");
+                c->wait_for({"LEFT"});
+                std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            }
+        }
+
+        a.send_line("START");
+        if (a.wait_for({"GAME "}).empty() || b.wait_for({"GAME "}).empty())
+            return fail(pair, "START");
+
+        std::string letters = "ABCDEFGHIJKLMNOPRSTUWYZ";
+        std::shuffle(letters.begin(), letters.end(), gen);
+        for (int i = 0; i < 8; i++)
+            (gen() % 2 ? a : b).send_line(std::string("GUESS ") + letters[i]);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+        for (TestClient* c : {&a, &b}) {
+            c->send_line("LEAVE");
+            if (c->wait_for({"LEFT"}).empty())
+                return fail(pair, "LEAVE");
+        }
+
+        rounds_played.fetch_add(1);
+    }
+
+    close(a.fd);
+    close(b.fd);
+}
+
+// Reaktor właściciela pokoju o danym id (jak w RoomDirectory::add).
+int owner_of(int id) {
+    return (id & RoomDirectory::SLOT_MASK) % stress.reactors;
+}
+
+// Gracz siedzący we własnym pokoju próbuje wejść do pokoju target na innym
+// reaktorze i dostaje odmowę reply; odmowa nie może go wyrzucić z pokoju.
+void refused_join(int id, int target, const char* reply, const char* step) {
+    TestClient x;
+    if (!x.connect_to(stress.port, "rx" + std::to_string(id)))
+        return fail(id, step);
+
+    // Pokoje dostają reaktory po kolei, więc któryś z kolejnych trafi obok.
+    int home = -1;
+    for (int k = 0; k < stress.reactors && (home < 0 || owner_of(home) == owner_of(target)); k++) {
+        std::string name = "home" + std::to_string(id) + "_" + std::to_string(k);
+        x.send_line("CREATE " + name);
+        home = x.wait_for_room(name);
+    }
+    if (home < 0 || owner_of(home) == owner_of(target))
+        return fail(id, step);
+
+    x.send_line("JOIN " + std::to_string(home));
+    if (x.wait_for({"JOINED"}).empty())
+        return fail(id, step);
+
+    x.send_line("JOIN " + std::to_string(target));
+    Room* room = get_room(home);
+    if (x.wait_for({reply, "JOINED"}).compare(0, strlen(reply), reply) != 0 ||
+        !room || room->member_count.load() != 1)
+        return fail(id, step);
+
+    close(x.fd);
+}
+
+// Odmowy JOIN do pełnego pokoju i do pokoju w trakcie rundy na obcym
+// reaktorze.
+void refused_joins() {
+    TestClient members[5];
+    for (int i = 0; i < 5; i++)
+        if (!members[i].connect_to(stress.port, "rf" + std::to_string(i)))
+            return fail(-1, "NAME");
+
+    members[0].send_line("CREATE full");
+    int full = members[0].wait_for_room("full");
+    members[0].send_line("CREATE busy");
+    int busy = members[0].wait_for_room("busy");
+    if (full < 0 || busy < 0)
+        return fail(-1, "CREATE");
+
+    for (TestClient& m : members) {
+        m.send_line("JOIN " + std::to_string(full));
+        if (m.wait_for({"JOINED"}).empty())
+            return fail(-1, "JOIN full");
+    }
+
+    TestClient a, b;
+    if (!a.connect_to(stress.port, "rb0") || !b.connect_to(stress.port, "rb1"))
+        return fail(-2, "NAME");
+    for (TestClient* c : {&a, &b}) {
+        c->send_line("JOIN " + std::to_string(busy));
+        if (c->wait_for({"JOINED"}).empty())
+            return fail(-2, "JOIN busy");
+    }
+    a.send_line("START");
+    if (a.wait_for({"GAME "}).empty())
+        return fail(-2, "START");
+
+    refused_join(-1, full, "ERROR", "JOIN do pełnego pokoju");
+    refused_join(-2, busy, "WAITING", "JOIN w trakcie rundy");
+
+    for (TestClient* c : {&members[0], &members[1], &members[2], &members[3], &members[4], &a, &b})
+        close(c->fd);
+}
+
+uint64_t total(Counter ReactorMetrics::*field) {
+    uint64_t sum = 0;
+    for (Reactor* r : reactors)
+        sum += (r->metrics.*field).get();
+    return sum;
+}
+
+int main(int argc, char** argv) {
+    int opt;
+    while ((opt = getopt(argc, argv, "r:n:k:p:")) != -1) {
+        switch (opt) {
+        case 'r': stress.reactors = std::max(1, atoi(optarg)); break;
+        case 'n': stress.rooms = atoi(optarg); break;
+        case 'k': stress.rounds = atoi(optarg); break;
+        case 'p': stress.port = atoi(optarg); break;
+        default:
+            fprintf(stderr, "Użycie: %s [-r reaktory] [-n pokoje] [-k rundy] [-p port]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    // Klienci testu wysyłają komendy szybciej, niż pozwalają domyślne limity.
+    for (RateLimit& l : rate_limits)
+        l.per_second = 0;
+
+    Dictionary* dict = new Dictionary();
+    dict->load(build_dictionary_image(word_list));
+    dictionary.store(dict);
+
+    for (int i = 0; i < stress.reactors; i++) {
+        Reactor* r = create_reactor(i, stress.port);
+        if (!r)
+            return 2;
+        reactors.push_back(r);
+    }
+
+    for (Reactor* r : reactors)
+        r->thread = std::thread(reactor_loop, r);
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> pairs;
+    for (int i = 0; i < stress.rooms; i++)
+        pairs.emplace_back(play_pair, i);
+    for (auto& t : pairs)
+        t.join();
+
+    if (stress.reactors > 1)
+        refused_joins();
+
+    // Zamknięcia docierają do reaktorów asynchronicznie.
+    uint64_t opened = 0, closed = 0;
+    for (int i = 0; i < 500; i++) {
+        opened = total(&ReactorMetrics::connections_opened);
+        closed = total(&ReactorMetrics::connections_closed);
+        if (opened == closed)
+            break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    int occupied = 0;
+    int listed = 0;
+    {
+        std::lock_guard<std::mutex> lock(lobby_mutex);
+        rooms.for_each([&](Room* room) {
+            listed++;
+            if (room->member_count.load() != 0)
+                occupied++;
+        });
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    int expected = stress.rooms * stress.rounds;
+    bool ok = failures == 0 && rounds_played == expected && opened == closed && occupied == 0;
+
+    printf("{\"reactors\":%d,\"rooms\":%d,\"listed\":%d,\"rounds\":%d,\"expected\":%d,"
+           "\"failures\":%d,\"connections_opened\":%lu,\"connections_closed\":%lu,"
+           "\"occupied_rooms\":%d,\"seconds\":%.2f,\"ok\":%s}\n",
+           stress.reactors, stress.rooms, listed, rounds_played.load(), expected,
+           failures.load(), (unsigned long)opened, (unsigned long)closed, occupied, seconds,
+           ok ? "true" : "false");
+    fflush(stdout);
+
+    // Reaktory nie mają ścieżki zatrzymania, a destruktory globalnych tablic
+    // działałyby pod ich nogami.
+    _exit(ok ? 0 : 1);
+}
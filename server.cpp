@@ -14,13 +14,34 @@
 #include <random>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
 #include <atomic>
 #include <chrono>
 #include <queue>
 #include <iomanip>
 #include <fcntl.h>
 #include <errno.h>
-
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <memory>
+#include <string_view>
+#include <charconv>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <sys/uio.h>
+#include <deque>
+#include <csignal>
+#include <pthread.h>
+#include "dictionary.h"
+#include "leaderboard.h"
+#include "log.h"
+#include "metrics.h"
+
+
+// Nick gracza jest zapisywany raz, w rejestrze nicków; klient, gracze w
+// rundzie i komunikaty pokoju współdzielą ten sam niezmienny napis.
+using Name = std::shared_ptr<const std::string>;
 
 enum class GameState {
     WAITING,
@@ -28,595 +49,1965 @@ enum class GameState {
     FINISHED
 };
 
-struct Client {
-    int fd;
-    int room_id;
-    std::string name;
-    time_t join_time;
-    bool ready_for_next;
+// Bufor wejściowy połączenia. Niepełna linia zostaje w buforze do kolejnego
+// recv, a komendy są parsowane bezpośrednio z jego pamięci.
+struct LineBuffer {
+    static const size_t CAPACITY = 4096;
+
+    std::vector<char> data;
+    size_t start = 0;
+    size_t end = 0;
+
+    void prepare() {
+        if (data.empty())
+            data.resize(CAPACITY);
+    }
+
+    char* tail() { return data.data() + end; }
+    size_t space() const { return data.size() - end; }
+    void commit(size_t n) { end += n; }
+
+    bool peek_line(std::string_view& line) const {
+        const char* base = data.data() + start;
+        const char* nl = (const char*)memchr(base, '\n', end - start);
+        if (!nl)
+            return false;
+
+        line = std::string_view(base, nl - base);
+        return true;
+    }
+
+    void consume(size_t n) {
+        start += n;
+        if (start == end)
+            start = end = 0;
+    }
+
+    void compact() {
+        memmove(data.data(), data.data() + start, end - start);
+        end -= start;
+        start = 0;
+    }
+
+    void clear() { start = end = 0; }
 };
 
-struct PlayerState {
-    int fd;
-    std::string name;
-    int hangman_stage;
-    std::vector<bool> guessed_letters;
-    bool guessed_word;
-    time_t game_start;
-    time_t finish_time;
-    bool active;
-    std::vector<char> wrong_letters;
-    std::vector<char> correct_letters;
+// Niezmienny bufor współdzielony przez wielu odbiorców (np. lista pokoi).
+using SharedBuffer = std::shared_ptr<const std::string>;
+
+// Rodzaj komunikatu w kolejce wyjściowej. Stan gry, odliczanie i lista pokoi
+// mają sens tylko w najnowszej wersji, więc nowa wersja zastępuje niewysłaną
+// starszą (klucz to id pokoju); pozostałe komunikaty są wysyłane wszystkie.
+enum MessageKind : uint8_t {
+    MSG_OTHER,
+    MSG_GAME,
+    MSG_GAME_DELTA,
+    MSG_TIME,
+    MSG_ROOMS
 };
 
-struct Room {
-    std::string name;
-    std::vector<int> client_fds;
-    GameState state;
-    std::string secret_word;
-    std::vector<PlayerState> players;
-    time_t game_start;
-    int time_limit;
-    int current_round;
-    std::map<int, time_t> join_times;
-    std::thread* game_thread;
-    std::atomic<bool> game_running;
+// Pełny GAME zastępuje także wcześniejsze delty tego pokoju.
+inline bool supersedes(MessageKind fresh, MessageKind old) {
+    if (fresh == MSG_OTHER || fresh == MSG_GAME_DELTA)
+        return false;
+    return fresh == old || (fresh == MSG_GAME && old == MSG_GAME_DELTA);
+}
 
-    Room()
-        : state(GameState::WAITING),
-          time_limit(120),
-          current_round(0),
-          game_thread(nullptr),
-          game_running(false) {}
+// Kolejka wyjściowa połączenia. Trzyma referencje do buforów zamiast kopii,
+// więc ten sam komunikat w kolejkach wielu klientów zajmuje pamięć raz.
+struct OutputBuffer {
+    struct Chunk {
+        SharedBuffer buf;
+        MessageKind kind;
+        int key;
+        std::chrono::steady_clock::time_point queued;
+    };
+
+    std::deque<Chunk> chunks;
+    size_t offset = 0;
+    size_t bytes = 0;
+
+    size_t pending() const { return bytes; }
+
+    // Wstawia komunikat na koniec kolejki, usuwając wcześniej zakolejkowane
+    // wersje, które zastępuje (poza pierwszym, już częściowo wysłanym).
+    // Nowa wersja dziedziczy czas oczekiwania usuniętych, więc podmiany nie
+    // ukrywają opóźnienia klienta. Zwraca liczbę usuniętych komunikatów.
+    int push(SharedBuffer buf, size_t skip, MessageKind kind = MSG_OTHER, int key = 0) {
+        auto queued = std::chrono::steady_clock::now();
+        int dropped = 0;
+
+        if (kind != MSG_OTHER) {
+            size_t first = offset > 0 ? 1 : 0;
+            for (size_t i = first; i < chunks.size(); ) {
+                if (chunks[i].key == key && supersedes(kind, chunks[i].kind)) {
+                    queued = std::min(queued, chunks[i].queued);
+                    bytes -= chunks[i].buf->size() - (i == 0 ? offset : 0);
+                    chunks.erase(chunks.begin() + i);
+                    dropped++;
+                } else {
+                    i++;
+                }
+            }
+        }
 
-    Room(const Room&) = delete;
-    Room& operator=(const Room&) = delete;
+        if (chunks.empty()) {
+            offset = skip;
+        } else {
+            skip = 0;
+            chunks.front().queued = std::min(chunks.front().queued, queued);
+        }
 
-    Room(Room&& other) noexcept
-        : name(std::move(other.name)),
-          client_fds(std::move(other.client_fds)),
-          state(other.state),
-          secret_word(std::move(other.secret_word)),
-          players(std::move(other.players)),
-          game_start(other.game_start),
-          time_limit(other.time_limit),
-          current_round(other.current_round),
-          join_times(std::move(other.join_times)),
-          game_thread(other.game_thread),
-          game_running(other.game_running.load()) {
-        other.game_thread = nullptr;
-        other.game_running = false;
-    }
-
-    Room& operator=(Room&& other) noexcept {
-        if (this != &other) {
-            if (game_thread && game_running) {
-                game_running = false;
-                game_thread->join();
-                delete game_thread;
-            }
+        bytes += buf->size() - skip;
+        chunks.push_back({std::move(buf), kind, key, queued});
+        return dropped;
+    }
 
-            name = std::move(other.name);
-            client_fds = std::move(other.client_fds);
-            state = other.state;
-            secret_word = std::move(other.secret_word);
-            players = std::move(other.players);
-            game_start = other.game_start;
-            time_limit = other.time_limit;
-            current_round = other.current_round;
-            join_times = std::move(other.join_times);
-            game_thread = other.game_thread;
-            game_running = other.game_running.load();
+    // Jak długo klient czeka na najstarsze niedostarczone dane.
+    std::chrono::steady_clock::duration lag() const {
+        if (chunks.empty())
+            return std::chrono::steady_clock::duration::zero();
+        return std::chrono::steady_clock::now() - chunks.front().queued;
+    }
 
-            other.game_thread = nullptr;
-            other.game_running = false;
+    int fill_iov(iovec* iov, int max) const {
+        int n = 0;
+        for (size_t i = 0; i < chunks.size() && n < max; i++, n++) {
+            size_t skip = i == 0 ? offset : 0;
+            iov[n].iov_base = const_cast<char*>(chunks[i].buf->data() + skip);
+            iov[n].iov_len = chunks[i].buf->size() - skip;
         }
-        return *this;
+        return n;
     }
 
-    ~Room() {
-        if (game_thread && game_running) {
-            game_running = false;
-            game_thread->join();
-            delete game_thread;
+    void consume(size_t n) {
+        bytes -= n;
+
+        while (n > 0) {
+            size_t left = chunks.front().buf->size() - offset;
+            if (n < left) {
+                offset += n;
+                return;
+            }
+
+            n -= left;
+            chunks.pop_front();
+            offset = 0;
         }
     }
 };
 
+const size_t OUTPUT_HIGH_WATER = 1 << 20;
+// Klient, u którego najstarszy niewysłany komunikat czeka dłużej, jest
+// rozłączany przy następnej próbie wysłania mu czegokolwiek.
+const auto OUTPUT_LAG_LIMIT = std::chrono::seconds(5);
+
+// Limity komend na połączenie: wspólny dla wszystkich komend (RATE_ALL) i
+// osobny dla każdej klasy. Komenda przechodzi, gdy pozwalają oba.
+enum RateClass {
+    RATE_ALL,
+    RATE_GUESS,
+    RATE_CHAT,
+    RATE_LOBBY,
+    RATE_ROOM,
+    RATE_CLASS_COUNT
+};
 
-std::vector<Client> clients;
-std::vector<Room*> rooms;
-
-std::mutex clients_mutex;
-std::mutex rooms_mutex;
-
-std::vector<std::string> word_list = {
-    "PROGRAMOWANIE", "KOMPUTER", "INTERNET", "SERWER", "KLIENT",
-    "ALGORYTM", "SZYFR", "HASLO", "GRACZ",
-    "WISIELEC", "RYWALIZACJA", "SIEC", "ROZGRYWKA", "TURNIEJ",
-    "ZWYCIESTWO", "PORAZKA", "WYTRWALOSC", "INTELIGENCJA", "LOGIKA",
-    "STRATEGIA", "KOMUNIKACJA", "INFORMACJA", "TECHNOLOGIA", "ROZWOJ"
+struct RateLimit {
+    const char* name;
+    uint32_t per_second;  // 0 wyłącza limit
+    uint32_t burst;
 };
 
+// Ustawiane opcją -q przed startem reaktorów, potem tylko czytane.
+RateLimit rate_limits[RATE_CLASS_COUNT] = {
+    {"ALL", 50, 100},
+    {"GUESS", 10, 26},
+    {"CHAT", 2, 5},
+    {"LOBBY", 1, 3},
+    {"ROOM", 5, 10},
+};
 
-Client* get_client(int fd) {
-    std::lock_guard<std::mutex> lock(clients_mutex);
-    for (auto& c : clients) {
-        if (c.fd == fd)
-            return &c;
+// Kubełek żetonów zapisany jako teoretyczny czas następnej komendy (GCRA):
+// jedna liczba na klasę i bez osobnego uzupełniania. Zera na starcie
+// połączenia oznaczają pełne kubełki.
+struct CommandRate {
+    int64_t next_us[RATE_CLASS_COUNT] = {};
+    uint8_t rejected = 0;
+    // Bieżąca linia została już policzona przez reaktor, który przekazał
+    // klienta dalej; reaktor docelowy wykonuje ją bez ponownego pobrania.
+    bool prepaid = false;
+
+    static int64_t interval(const RateLimit& l) {
+        return 1000000 / l.per_second;
     }
-    return nullptr;
-}
 
-Room* get_room(int room_id) {
-    std::lock_guard<std::mutex> lock(rooms_mutex);
-    if (room_id >= 0 && room_id < (int)rooms.size())
-        return rooms[room_id];
-    return nullptr;
-}
-
-void remove_client_from_rooms_unlocked(int fd) {
-    for (auto room : rooms) {
-        room->client_fds.erase(
-            std::remove(room->client_fds.begin(), room->client_fds.end(), fd),
-            room->client_fds.end()
-        );
+    bool allows(int cls, int64_t now_us) const {
+        const RateLimit& l = rate_limits[cls];
+        if (l.per_second == 0)
+            return true;
+        return next_us[cls] - now_us <= (int64_t)(l.burst - 1) * interval(l);
+    }
 
-        room->players.erase(
-            std::remove_if(room->players.begin(), room->players.end(),
-                [fd](const PlayerState& p) { return p.fd == fd; }),
-            room->players.end()
-        );
+    void take(int cls, int64_t now_us) {
+        const RateLimit& l = rate_limits[cls];
+        if (l.per_second != 0)
+            next_us[cls] = std::max(next_us[cls], now_us) + interval(l);
+    }
 
-        room->join_times.erase(fd);
+    // Zwraca klasę, której limit odrzucił komendę, albo -1.
+    int admit(int cls, int64_t now_us) {
+        int refused = !allows(RATE_ALL, now_us) ? RATE_ALL
+                    : !allows(cls, now_us) ? cls
+                    : -1;
+        if (refused >= 0)
+            return refused;
+
+        take(RATE_ALL, now_us);
+        if (cls != RATE_ALL)
+            take(cls, now_us);
+        rejected = 0;
+        return -1;
     }
-}
+};
 
-void remove_client_from_rooms(int fd) {
-    std::lock_guard<std::mutex> lock(rooms_mutex);
-    remove_client_from_rooms_unlocked(fd);
-}
+struct Client {
+    int fd = -1;
+    int room_id = -1;
+    Name name;
+    time_t join_time = 0;
+    bool ready_for_next = false;
+    LineBuffer input;
+    OutputBuffer output;
+    bool want_write = false;
+    bool closing = false;
+    bool queued = false;
+    bool wants_delta = false;
+    CommandRate rate;
+    size_t reactor_pos = 0;
+};
 
-bool nickname_taken(const std::string& name) {
-    std::lock_guard<std::mutex> lock(clients_mutex);
-    for (const auto& c : clients) {
-        if (c.name == name)
-            return true;
+struct ClientHandle {
+    int fd = -1;
+    uint32_t generation = 0;
+};
+
+// Tabela połączeń indeksowana numerem deskryptora. Sloty są alokowane blokami,
+// które nigdy nie są przenoszone, więc wskaźnik do Client pozostaje ważny do
+// zamknięcia połączenia, a wyszukiwanie działa w O(1) i bez blokady z każdego
+// wątku. Numer generacji w ClientHandle wykrywa ponowne użycie deskryptora.
+// Pola Client zmienia tylko reaktor, do którego połączenie należy.
+struct ConnectionTable {
+    static const int CHUNK_BITS = 12;
+    static const int CHUNK_SIZE = 1 << CHUNK_BITS;
+    static const int MAX_CHUNKS = 1024;
+
+    struct Slot {
+        std::atomic<uint32_t> generation{0};
+        std::atomic<int> reactor{-1};
+        Client client;
+    };
+
+    std::atomic<Slot*> chunks[MAX_CHUNKS] = {};
+
+    Slot* slot(int fd) const {
+        if (fd < 0 || (fd >> CHUNK_BITS) >= MAX_CHUNKS)
+            return nullptr;
+
+        Slot* chunk = chunks[fd >> CHUNK_BITS].load(std::memory_order_acquire);
+        return chunk ? &chunk[fd & (CHUNK_SIZE - 1)] : nullptr;
     }
-    return false;
-}
 
-std::string generate_word() {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dist(0, word_list.size() - 1);
-    return word_list[dist(gen)];
-}
+    Slot* ensure_slot(int fd) {
+        if (fd < 0 || (fd >> CHUNK_BITS) >= MAX_CHUNKS)
+            return nullptr;
 
-void init_game(Room* room) {
-    std::lock_guard<std::mutex> lock(rooms_mutex);
+        std::atomic<Slot*>& entry = chunks[fd >> CHUNK_BITS];
+        Slot* chunk = entry.load(std::memory_order_acquire);
 
-    room->state = GameState::PLAYING;
-    room->current_round++;
-    room->secret_word = generate_word();
-    room->game_start = time(nullptr);
+        if (!chunk) {
+            Slot* fresh = new Slot[CHUNK_SIZE];
+            if (entry.compare_exchange_strong(chunk, fresh, std::memory_order_acq_rel))
+                chunk = fresh;
+            else
+                delete[] fresh;
+        }
 
-    room->players.clear();
+        return &chunk[fd & (CHUNK_SIZE - 1)];
+    }
 
-    for (int fd : room->client_fds) {
-        Client* c = get_client(fd);
-        if (!c)
-            continue;
+    Client* insert(int fd, int reactor) {
+        Slot* s = ensure_slot(fd);
+        if (!s)
+            return nullptr;
+
+        // Deskryptor mógł właśnie zostać zwolniony przez inny reaktor; odczyt
+        // generacji synchronizuje się z końcem jego erase().
+        s->generation.load(std::memory_order_acquire);
+        s->client = Client();
+        s->client.fd = fd;
+        s->client.join_time = time(nullptr);
+        s->generation.fetch_add(1, std::memory_order_acq_rel);
+        s->reactor.store(reactor, std::memory_order_release);
+        return &s->client;
+    }
 
-        PlayerState p;
-        p.fd = fd;
-        p.name = c->name;
-        p.hangman_stage = 0;
-        p.guessed_letters.assign(room->secret_word.size(), false);
-        p.guessed_word = false;
-        p.game_start = room->game_start;
-        p.finish_time = 0;
-        p.active = true;
+    void erase(int fd) {
+        Slot* s = slot(fd);
+        if (!s)
+            return;
 
-        room->players.push_back(p);
+        s->reactor.store(-1, std::memory_order_release);
+        s->client = Client();
+        s->generation.fetch_add(1, std::memory_order_acq_rel);
     }
 
-    std::cout << "Rozpoczęto grę w pokoju '" << room->name
-              << "' z hasłem: " << room->secret_word << std::endl;
-}
+    Client* find(int fd, int reactor) const {
+        Slot* s = slot(fd);
+        if (!s || s->reactor.load(std::memory_order_acquire) != reactor)
+            return nullptr;
+        return &s->client;
+    }
 
-void process_guess(Room* room, PlayerState& player, char letter) {
-    letter = toupper(letter);
+    ClientHandle handle(int fd) const {
+        Slot* s = slot(fd);
+        if (!s)
+            return ClientHandle();
+        return {fd, s->generation.load(std::memory_order_acquire)};
+    }
 
-    if (std::find(player.correct_letters.begin(), player.correct_letters.end(), letter) != player.correct_letters.end() ||
-        std::find(player.wrong_letters.begin(), player.wrong_letters.end(), letter) != player.wrong_letters.end())
-        return;
+    bool valid(ClientHandle h) const {
+        Slot* s = slot(h.fd);
+        return s && s->generation.load(std::memory_order_acquire) == h.generation;
+    }
 
-    bool found = false;
+    // Przekazanie własności połączenia innemu reaktorowi (-1: w drodze).
+    Client* transfer(ClientHandle h, int reactor) {
+        if (!valid(h))
+            return nullptr;
 
-    for (size_t i = 0; i < room->secret_word.size(); ++i) {
-        if (room->secret_word[i] == letter) {
-            player.guessed_letters[i] = true;
-            found = true;
-        }
+        Slot* s = slot(h.fd);
+        s->reactor.store(reactor, std::memory_order_release);
+        return &s->client;
     }
+};
 
-    if (found) {
-        player.correct_letters.push_back(letter);
+// Pola gracza zmienione od ostatniego wysłania stanu (GAME_DELTA).
+enum PlayerField : unsigned {
+    FIELD_STAGE = 1 << 0,
+    FIELD_GUESSED = 1 << 1,
+    FIELD_WRONG = 1 << 2,
+    FIELD_ACTIVE = 1 << 3,
+    FIELD_DONE = 1 << 4,
+    FIELD_PROGRESS = 1 << 5
+};
 
-        bool complete = true;
-        for (bool g : player.guessed_letters) {
-            if (!g) {
-                complete = false;
-                break;
-            }
-        }
+enum PlayerFlag : uint8_t {
+    PLAYER_ACTIVE = 1 << 0,
+    PLAYER_GUESSED = 1 << 1
+};
 
-        if (complete) {
-            player.guessed_word = true;
-            player.finish_time = time(nullptr);
-            player.active = false;
+// Stan graczy w rundzie jako równoległe tablice o wspólnym indeksie. Pętle
+// wykonywane po każdym ruchu (is_game_finished, GAME, GAME_DELTA) czytają
+// tylko potrzebne, zwarte kolumny; fd i nicki leżą osobno. Kolejność graczy
+// jest kolejnością w komunikacie GAME.
+struct RoundPlayers {
+    std::vector<uint8_t> stage;
+    std::vector<uint8_t> flags;
+    std::vector<uint8_t> changed;
+    std::vector<uint32_t> tried;
+    std::vector<uint64_t> revealed;
+    std::vector<uint32_t> finish_ms;
+
+    std::vector<int> fd;
+    std::vector<Name> name;
+
+    // Indeksy graczy w kolejności odgadnięcia hasła, dopisywane w chwili
+    // odgadnięcia - ranking na końcu rundy nie musi niczego sortować.
+    std::vector<uint32_t> finish_order;
+
+    size_t size() const {
+        return fd.size();
+    }
 
-            std::cout << "Gracz " << player.name
-                      << " odgadł hasło w pokoju '"
-                      << room->name << "'" << std::endl;
-        }
-    } else {
-        player.wrong_letters.push_back(letter);
-        player.hangman_stage++;
+    void clear() {
+        stage.clear();
+        flags.clear();
+        changed.clear();
+        tried.clear();
+        revealed.clear();
+        finish_ms.clear();
+        fd.clear();
+        name.clear();
+        finish_order.clear();
+    }
+
+    void add(int player_fd, const Name& player_name) {
+        stage.push_back(0);
+        flags.push_back(PLAYER_ACTIVE);
+        changed.push_back(0);
+        tried.push_back(0);
+        revealed.push_back(0);
+        finish_ms.push_back(0);
+        fd.push_back(player_fd);
+        name.push_back(player_name);
+    }
 
-        if (player.hangman_stage >= 6) {
-            player.active = false;
-            std::cout << "Gracz " << player.name
-                      << " odpadł w pokoju '"
-                      << room->name << "'" << std::endl;
+    int find(int player_fd) const {
+        for (size_t i = 0; i < fd.size(); i++) {
+            if (fd[i] == player_fd)
+                return i;
         }
+        return -1;
     }
-}
 
-bool is_game_finished(Room* room) {
-    time_t now = time(nullptr);
+    void remove(size_t i) {
+        stage.erase(stage.begin() + i);
+        flags.erase(flags.begin() + i);
+        changed.erase(changed.begin() + i);
+        tried.erase(tried.begin() + i);
+        revealed.erase(revealed.begin() + i);
+        finish_ms.erase(finish_ms.begin() + i);
+        fd.erase(fd.begin() + i);
+        name.erase(name.begin() + i);
+
+        finish_order.erase(std::remove(finish_order.begin(), finish_order.end(), (uint32_t)i),
+                           finish_order.end());
+        for (uint32_t& f : finish_order) {
+            if (f > i)
+                f--;
+        }
+    }
 
-    if (now - room->game_start > room->time_limit) {
-        std::cout << "Czas gry wyczerpany w pokoju '"
-                  << room->name << "'" << std::endl;
-        return true;
+    void finish(size_t i, uint32_t ms) {
+        flags[i] = PLAYER_GUESSED;
+        finish_ms[i] = ms;
+        finish_order.push_back(i);
     }
 
-    bool all_done = true;
-    int active_count = 0;
+    bool active(size_t i) const {
+        return flags[i] & PLAYER_ACTIVE;
+    }
 
-    for (const auto& p : room->players) {
-        if (!p.guessed_word && p.active) {
-            all_done = false;
-            active_count++;
-        }
+    bool guessed(size_t i) const {
+        return flags[i] & PLAYER_GUESSED;
     }
+};
 
-    if (all_done || active_count <= 1) {
-        std::cout << "Gra zakończona w pokoju '"
-                  << room->name
-                  << "', aktywnych graczy: "
-                  << active_count << std::endl;
-        return true;
+// Hasło rundy rozłożone na maski pozycji: positions[l] ma ustawione bity
+// miejsc, w których występuje litera 'A' + l. Ruch gracza to wtedy kilka
+// operacji na bitach zamiast przeszukiwania wektorów.
+struct CompiledWord {
+    static const size_t MAX_LENGTH = 64;
+
+    uint64_t positions[26] = {};
+    uint64_t full = 0;
+    uint32_t letters = 0;
+};
+
+CompiledWord compile_word(const std::string& word) {
+    CompiledWord w;
+
+    for (size_t i = 0; i < word.size() && i < CompiledWord::MAX_LENGTH; i++) {
+        int l = toupper((unsigned char)word[i]) - 'A';
+        if (l < 0 || l >= 26)
+            continue;
+
+        w.positions[l] |= 1ull << i;
+        w.full |= 1ull << i;
+        w.letters |= 1u << l;
     }
 
-    return false;
+    return w;
 }
 
-std::string build_ranking(Room* room) {
-    std::vector<PlayerState> ranked = room->players;
-
-    std::sort(ranked.begin(), ranked.end(),
-        [](const PlayerState& a, const PlayerState& b) {
-            if (a.guessed_word && !b.guessed_word) return true;
-            if (!a.guessed_word && b.guessed_word) return false;
+struct Room {
+    int id;
+    std::string name;
+    int owner;
+    std::vector<int> client_fds;
+    std::atomic<int> member_count;
+    std::atomic<GameState> state;
+    std::string secret_word;
+    CompiledWord word;
+    WordCriteria criteria;
+    RoundPlayers players;
+    time_t game_start;
+    std::chrono::steady_clock::time_point round_start;
+    int time_limit;
+    int current_round;
+    uint64_t round_epoch;
+    bool state_dirty;
+    bool keyframe_due;
+    uint64_t idle_epoch;
+    std::map<int, time_t> join_times;
 
-            if (a.guessed_word && b.guessed_word) {
-                return (a.finish_time - a.game_start) <
-                       (b.finish_time - b.game_start);
-            }
+    Room()
+        : id(-1),
+          owner(0),
+          member_count(0),
+          state(GameState::WAITING),
+          time_limit(120),
+          current_round(0),
+          round_epoch(0),
+          state_dirty(false),
+          keyframe_due(false),
+          idle_epoch(0) {}
+
+    // Przygotowanie slotu do ponownego użycia. Kontenery zachowują pojemność,
+    // a epoki rosną dalej, żeby zegary poprzedniego pokoju nie zadziałały.
+    void reset() {
+        name.clear();
+        client_fds.clear();
+        member_count = 0;
+        state = GameState::WAITING;
+        secret_word.clear();
+        criteria = WordCriteria();
+        players.clear();
+        time_limit = 120;
+        current_round = 0;
+        round_epoch++;
+        keyframe_due = false;
+        idle_epoch++;
+        join_times.clear();
+    }
 
-            return a.hangman_stage < b.hangman_stage;
-        });
+    Room(const Room&) = delete;
+    Room& operator=(const Room&) = delete;
+};
 
-    std::ostringstream oss;
-    oss << " RANKING - KONIEC GRY \n";
-    oss << "═══════════════════════════\n\n";
 
-    int position = 1;
+// Hierarchiczne koło czasowe reaktora: 4 poziomy po 64 sloty, tick 10 ms,
+// zasięg ok. 46 h. Zegary z wyższych poziomów są przenoszone niżej, gdy
+// niższy poziom zatoczy pełny obrót. Wszystkie zegary rund pokoi działają
+// na wątku reaktora, który jest właścicielem pokoju.
+struct TimerWheel {
+    static const int LEVELS = 4;
+    static const int SLOT_BITS = 6;
+    static const int SLOTS = 1 << SLOT_BITS;
+    static const int TICK_MS = 10;
+
+    struct Timer {
+        uint64_t expires;
+        std::function<void()> callback;
+    };
+
+    std::vector<Timer> slots[LEVELS][SLOTS];
+    std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+    uint64_t now_tick = 0;
+    size_t pending = 0;
+
+    void schedule(int delay_ms, std::function<void()> callback) {
+        uint64_t ticks = (delay_ms + TICK_MS - 1) / TICK_MS;
+        if (ticks == 0)
+            ticks = 1;
+
+        insert({now_tick + ticks, std::move(callback)});
+        pending++;
+    }
 
-    for (size_t i = 0; i < ranked.size(); ++i) {
-        const auto& p = ranked[i];
+    // Najbliższy tick, w którym koło ma coś do zrobienia: odpalenie zegara
+    // z poziomu 0 albo przeniesienie slotu z wyższego poziomu. 0 - brak zegarów.
+    uint64_t next_tick() const {
+        if (pending == 0)
+            return 0;
 
-        if (i > 0 && p.guessed_word && ranked[i - 1].guessed_word) {
-            double prev = difftime(ranked[i - 1].finish_time, ranked[i - 1].game_start);
-            double curr = difftime(p.finish_time, p.game_start);
-            if (fabs(prev - curr) >= 0.01)
-                position = i + 1;
-        } else {
-            position = i + 1;
+        uint64_t best = 0;
+        for (uint64_t t = now_tick + 1; t <= now_tick + SLOTS; t++) {
+            if (!slots[0][t & (SLOTS - 1)].empty()) {
+                best = t;
+                break;
+            }
         }
 
-        oss << position << ". " << p.name << "\n";
+        // Slot poziomu L jest przenoszony w ticku będącym wielokrotnością 64^L.
+        for (int level = 1; level < LEVELS; level++) {
+            uint64_t span = 1ull << (SLOT_BITS * level);
+            uint64_t at = (now_tick / span + 1) * span;
 
-        if (p.guessed_word) {
-            double t = difftime(p.finish_time, p.game_start);
-            oss << "      Czas: " << std::fixed << std::setprecision(2)
-                << t << "s | Błędów: "
-                << p.hangman_stage << "\n";
-        } else {
-            oss << "     DNF";
-            if (p.hangman_stage >= 6) {
-                oss << " (odpadł po " << p.hangman_stage << " błędach)\n";
-            } else {
-                oss << " (nie ukończył w czasie)";
-                if (p.hangman_stage > 0)
-                    oss << " | Błędów: " << p.hangman_stage;
-                oss << "\n";
+            for (int i = 0; i < SLOTS && (best == 0 || at < best); i++, at += span) {
+                if (!slots[level][(at >> (SLOT_BITS * level)) & (SLOTS - 1)].empty()) {
+                    best = at;
+                    break;
+                }
             }
         }
 
-        oss << "\n";
+        return best;
     }
 
-    oss << "═══════════════════════════\n";
-    oss << "Właściciel może rozpocząć nową grę";
+    void insert(Timer timer) {
+        uint64_t max_delta = (1ull << (SLOT_BITS * LEVELS)) - 1;
+        if (timer.expires - now_tick > max_delta)
+            timer.expires = now_tick + max_delta;
 
-    return oss.str();
-}
+        uint64_t delta = timer.expires - now_tick;
+        int level = 0;
+        while (level < LEVELS - 1 && delta >= (1ull << (SLOT_BITS * (level + 1))))
+            level++;
 
-std::string player_progress(const PlayerState& p, const std::string& word) {
-    std::string out;
-    for (size_t i = 0; i < word.size(); ++i) {
-        if (p.guessed_letters[i])
-            out += word[i];
-        else
-            out += '_';
+        int slot = (timer.expires >> (SLOT_BITS * level)) & (SLOTS - 1);
+        slots[level][slot].push_back(std::move(timer));
     }
-    return out;
-}
 
-void send_game_state(Room* room) {
-    std::ostringstream oss;
+    void cascade(int level) {
+        int slot = (now_tick >> (SLOT_BITS * level)) & (SLOTS - 1);
 
-    time_t now = time(nullptr);
-    int time_left = room->time_limit - (now - room->game_start);
-    if (time_left < 0)
-        time_left = 0;
+        std::vector<Timer> timers;
+        timers.swap(slots[level][slot]);
+        for (auto& t : timers)
+            insert(std::move(t));
 
-    oss << "GAME "
-        << room->secret_word.length() << " "
-        << time_left << " "
-        << room->players.size();
+        if (slot == 0 && level + 1 < LEVELS)
+            cascade(level + 1);
+    }
 
-    for (const auto& p : room->players) {
-        std::string progress = player_progress(p, room->secret_word);
+    void advance() {
+        auto elapsed = std::chrono::steady_clock::now() - origin;
+        uint64_t target = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() / TICK_MS;
 
-        int guessed = 0;
-        for (bool g : p.guessed_letters)
-            if (g) guessed++;
+        while (now_tick < target) {
+            // Puste koło: nie ma czego przenosić ani odpalać po drodze.
+            if (pending == 0) {
+                now_tick = target;
+                break;
+            }
 
-        oss << " " << p.name
-            << ":" << p.hangman_stage
-            << ":" << guessed
-            << ":";
+            now_tick++;
 
-        for (char c : p.wrong_letters)
-            oss << c;
+            if ((now_tick & (SLOTS - 1)) == 0)
+                cascade(1);
 
-        oss << ":"
-            << (p.active ? "1" : "0")
-            << ":" << (p.guessed_word ? "1" : "0")
-            << ":" << progress;
+            std::vector<Timer> due;
+            due.swap(slots[0][now_tick & (SLOTS - 1)]);
+            pending -= due.size();
+            for (auto& t : due)
+                t.callback();
+        }
     }
+};
 
-    oss << "\n";
-    std::string msg = oss.str();
-
-    std::cout << "DEBUG: Wysyłam stan gry do pokoju '"
-              << room->name << "': " << msg;
+// Komendy protokołu w kolejności histogramów opóźnień; ostatnia pozycja
+// zbiera nieznane komendy.
+const char* const COMMAND_NAMES[] = {
+    "GUESS", "NAME", "CREATE", "JOIN", "LEAVE", "START", "READY", "WORDS",
+    "RELOAD", "LEADERBOARD", "CHAT", "DELTA", "REFRESH", "OTHER"
+};
+const int COMMAND_COUNT = sizeof(COMMAND_NAMES) / sizeof(COMMAND_NAMES[0]);
+
+// Klasa limitu dla każdej pozycji COMMAND_NAMES. REFRESH i LEADERBOARD
+// odsyłają duże odpowiedzi, a CHAT trafia do całego pokoju, więc mają
+// najciaśniejsze limity.
+const RateClass COMMAND_RATE_CLASS[COMMAND_COUNT] = {
+    RATE_GUESS, RATE_ROOM, RATE_ROOM, RATE_ROOM, RATE_ROOM, RATE_ROOM, RATE_ROOM, RATE_ROOM,
+    RATE_ROOM, RATE_LOBBY, RATE_CHAT, RATE_ROOM, RATE_LOBBY, RATE_ALL
+};
 
-    for (int fd : room->client_fds) {
-        send(fd, msg.c_str(), msg.size(), MSG_NOSIGNAL);
-    }
-}
+using LatencyHistogram = Histogram<8, 20>;  // 256 ns .. 134 ms
+using FanoutHistogram = Histogram<0, 16>;   // 1 .. 65536 odbiorców
+
+struct ReactorMetrics {
+    Counter connections_opened;
+    Counter connections_closed;
+    Counter rooms_created;
+    Counter rooms_removed;
+    Counter games_started;
+    Counter games_finished;
+    Counter messages_in;
+    Counter bytes_in;
+    Counter messages_out;
+    Counter bytes_out;
+    Counter messages_coalesced;
+    Counter laggards_closed;
+    Counter commands_limited[RATE_CLASS_COUNT];
+    LatencyHistogram command_latency[COMMAND_COUNT];
+    FanoutHistogram room_fanout;
+    FanoutHistogram game_fanout;
+    FanoutHistogram lobby_fanout;
+};
 
-void game_loop(Room* room) {
-    room->game_running = true;
+struct Reactor {
+    int id;
+    int epfd;
+    int listen_fd;
+    int wake_fd;
+    int timer_fd;
+    uint64_t armed_tick = 0;
+    std::thread thread;
+    std::vector<int> client_fds;
+    std::vector<ClientHandle> closing;
+    std::deque<ClientHandle> ready;
+    std::vector<Room*> dirty_rooms;
+    TimerWheel timers;
+    uint64_t lobby_version = 0;
+    std::atomic<uint64_t> passes{0};
+    ReactorMetrics metrics;
+
+    std::mutex inbox_mutex;
+    std::vector<std::function<void()>> inbox;
+};
 
-    while (room->game_running && room->state == GameState::PLAYING) {
-        send_game_state(room);
+std::vector<Reactor*> reactors;
+thread_local Reactor* current_reactor = nullptr;
+
+ConnectionTable connections;
+
+// Wersja listy pokoi w lobby, podbijana przy każdej zmianie widocznej w ROOMS.
+std::atomic<uint64_t> lobby_version{1};
+// Chroni nazwy pokoi przed zmianą w trakcie budowy listy ROOMS: budowa czyta
+// room->name pokoi wszystkich reaktorów, a slot usuniętego pokoju może od
+// razu dostać nowy pokój. Brana przy CREATE, usuwaniu pokoju i przebudowie
+// listy (raz na wersję); gotowa lista jest czytana bez niej.
+std::mutex lobby_mutex;
+
+// Rejestr pokoi bez globalnej blokady. Pokój jest adresowany uchwytem
+// (generacja << SLOT_BITS | slot): po usunięciu pokoju generacja slotu rośnie,
+// więc stary uchwyt przestaje pasować i nie trafi do nowego pokoju w tym samym
+// slocie. Sloty są alokowane blokami, które nigdy nie są przenoszone ani
+// zwalniane - obiekt Room w slocie jest używany ponownie, a wolne sloty
+// czekają na stosie bez blokady. Właścicielem slotu jest zawsze ten sam
+// reaktor i tylko on zmienia stan pokoju; inne reaktory docierają do pokoju
+// przez jego skrzynkę (przekazanie klienta). Unikalność nazw pilnują części
+// rejestru z osobnymi blokadami, brane tylko przy CREATE i usuwaniu pokoju.
+struct RoomDirectory {
+    static const int SLOT_BITS = 16;
+    static const int SLOT_MASK = (1 << SLOT_BITS) - 1;
+    static const uint32_t GENERATION_MASK = (1u << (31 - SLOT_BITS)) - 1;
+    static const int CHUNK_BITS = 10;
+    static const int CHUNK_SIZE = 1 << CHUNK_BITS;
+    static const int MAX_CHUNKS = 1 << (SLOT_BITS - CHUNK_BITS);
+    static const size_t SHARDS = 16;
+
+    struct Slot {
+        std::atomic<uint32_t> generation{0};
+        std::atomic<bool> live{false};
+        std::atomic<uint32_t> next_free{0};
+        Room room;
+    };
+
+    struct NameShard {
+        std::mutex mutex;
+        std::unordered_set<std::string> names;
+    };
+
+    std::atomic<Slot*> chunks[MAX_CHUNKS] = {};
+    std::atomic<int> used{0};
+    // Wierzchołek stosu wolnych slotów: (licznik zmian << 32) | (slot + 1);
+    // licznik chroni przed problemem ABA.
+    std::atomic<uint64_t> free_head{0};
+    NameShard shards[SHARDS];
+
+    ~RoomDirectory() {
+        for (auto& chunk : chunks)
+            delete[] chunk.load();
+    }
 
-        if (is_game_finished(room)) {
-            room->state = GameState::FINISHED;
+    Slot* slot(int index) const {
+        if (index < 0 || index > SLOT_MASK)
+            return nullptr;
 
-            time_t now = time(nullptr);
-            for (auto& p : room->players) {
-                if (p.guessed_word && p.finish_time == 0)
-                    p.finish_time = now;
-            }
+        Slot* chunk = chunks[index >> CHUNK_BITS].load(std::memory_order_acquire);
+        return chunk ? &chunk[index & (CHUNK_SIZE - 1)] : nullptr;
+    }
 
-            std::string ranking = build_ranking(room);
-            std::string flat = ranking;
+    Slot* ensure_slot(int index) {
+        auto& entry = chunks[index >> CHUNK_BITS];
+        Slot* chunk = entry.load(std::memory_order_acquire);
 
-            size_t pos = 0;
-            while ((pos = flat.find('\n', pos)) != std::string::npos) {
-                flat.replace(pos, 1, "|");
-                pos++;
-            }
+        if (!chunk) {
+            Slot* fresh = new Slot[CHUNK_SIZE];
+            if (entry.compare_exchange_strong(chunk, fresh, std::memory_order_acq_rel))
+                chunk = fresh;
+            else
+                delete[] fresh;
+        }
 
-            room->state = GameState::WAITING;
-            room->current_round = 0;
-            room->players.clear();
+        return &chunk[index & (CHUNK_SIZE - 1)];
+    }
 
-            std::string lobby = "ROOM_LOBBY\n";
-            for (int fd : room->client_fds)
-                send(fd, lobby.c_str(), lobby.size(), MSG_NOSIGNAL);
+    NameShard& shard_for(const std::string& name) {
+        return shards[std::hash<std::string>()(name) % SHARDS];
+    }
 
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    int pop_free() {
+        uint64_t head = free_head.load(std::memory_order_acquire);
 
-            std::string msg = "RANKING_FULL " + flat + "\n";
-            for (int fd : room->client_fds)
-                send(fd, msg.c_str(), msg.size(), MSG_NOSIGNAL);
+        while ((uint32_t)head != 0) {
+            int index = (uint32_t)head - 1;
+            uint64_t next = ((head >> 32) + 1) << 32 |
+                            slot(index)->next_free.load(std::memory_order_relaxed);
+            if (free_head.compare_exchange_weak(head, next, std::memory_order_acq_rel))
+                return index;
+        }
 
-            break;
+        int index = used.fetch_add(1, std::memory_order_acq_rel);
+        if (index > SLOT_MASK) {
+            used.fetch_sub(1, std::memory_order_acq_rel);
+            return -1;
         }
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        ensure_slot(index);
+        return index;
     }
 
-    room->game_running = false;
-}
-
-void send_room_players(Room* room) {
-    std::ostringstream oss;
-    oss << "ROOM_PLAYERS";
+    void push_free(int index) {
+        Slot* s = slot(index);
+        uint64_t head = free_head.load(std::memory_order_relaxed);
 
-    for (int fd : room->client_fds) {
-        Client* c = get_client(fd);
-        if (c)
-            oss << " " << c->name;
+        do {
+            s->next_free.store((uint32_t)head, std::memory_order_relaxed);
+        } while (!free_head.compare_exchange_weak(head,
+                    ((head >> 32) + 1) << 32 | (uint32_t)(index + 1),
+                    std::memory_order_acq_rel));
     }
 
-    oss << "\n";
-    std::string msg = oss.str();
-
-    for (int fd : room->client_fds)
-        send(fd, msg.c_str(), msg.size(), MSG_NOSIGNAL);
-}
-
-void broadcast_rooms() {
-    std::lock_guard<std::mutex> lock(rooms_mutex);
+    Room* get(int id) const {
+        Slot* s = slot(id & SLOT_MASK);
+        if (!s || id < 0 || !s->live.load(std::memory_order_acquire) ||
+            (s->generation.load(std::memory_order_acquire) & GENERATION_MASK) !=
+                (uint32_t)id >> SLOT_BITS)
+            return nullptr;
+        return &s->room;
+    }
 
-    for (const auto& c : clients) {
-        std::ostringstream oss;
-        oss << "ROOMS " << rooms.size();
+    // Zajmuje slot dla nowego pokoju; nullptr, gdy nazwa jest zajęta
+    // (busy = true) albo skończyły się sloty.
+    Room* add(const std::string& name, bool& busy) {
+        NameShard& shard = shard_for(name);
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            busy = !shard.names.insert(name).second;
+            if (busy)
+                return nullptr;
+        }
 
-        for (const auto& room : rooms) {
-            oss << " " << room->name
-                << ":" << room->client_fds.size()
-                << ":" << (room->state == GameState::PLAYING ? "1" : "0");
+        int index = pop_free();
+        if (index < 0) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.names.erase(name);
+            return nullptr;
         }
 
-        oss << "\n";
-        std::string msg = oss.str();
-        send(c.fd, msg.c_str(), msg.size(), MSG_NOSIGNAL);
-    }
-}
+        Slot* s = slot(index);
+        Room* room = &s->room;
+        uint32_t generation = s->generation.load(std::memory_order_acquire) & GENERATION_MASK;
 
-void handle_name(int fd, const std::string& name) {
-    Client* c = get_client(fd);
-    if (!c)
-        return;
+        room->id = (int)(generation << SLOT_BITS) | index;
+        room->owner = index % reactors.size();
 
-    if (nickname_taken(name)) {
-        std::string msg = "ERROR Nickname already taken: " + name + "\n";
-        send(fd, msg.c_str(), msg.size(), MSG_NOSIGNAL);
-        return;
+        // Nazwę czyta też budowa listy ROOMS, więc zmienia się ona pod tą
+        // samą blokadą, razem z widocznością slotu.
+        std::lock_guard<std::mutex> lock(lobby_mutex);
+        room->name = name;
+        s->live.store(true, std::memory_order_release);
+        return room;
     }
 
-    c->name = name;
-    c->join_time = time(nullptr);
+    // Zwalnia slot pustego pokoju; wywoływane w wątku właściciela.
+    void remove(Room* room) {
+        Slot* s = slot(room->id & SLOT_MASK);
+        {
+            std::lock_guard<std::mutex> lock(lobby_mutex);
+            s->live.store(false, std::memory_order_release);
+        }
+        s->generation.fetch_add(1, std::memory_order_acq_rel);
 
-    std::string msg = "OK Nickname set to " + name + "\n";
-    send(fd, msg.c_str(), msg.size(), MSG_NOSIGNAL);
-}
+        NameShard& shard = shard_for(room->name);
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.names.erase(room->name);
+        }
 
-void handle_create(int fd, const std::string& room_name) {
-    Client* c = get_client(fd);
-    if (!c || c->name.empty()) {
-        std::string msg = "ERROR Najpierw ustaw nick\n";
-        send(fd, msg.c_str(), msg.size(), MSG_NOSIGNAL);
-        return;
+        int index = room->id & SLOT_MASK;
+        room->reset();
+        push_free(index);
     }
 
-    std::lock_guard<std::mutex> lock(rooms_mutex);
-
-    for (const auto& r : rooms) {
-        if (r->name == room_name) {
-            std::string msg = "ERROR Pokój o takiej nazwie istnieje\n";
-            send(fd, msg.c_str(), msg.size(), MSG_NOSIGNAL);
-            return;
+    // Aktywne pokoje w kolejności slotów; wołać pod lobby_mutex.
+    template <typename F>
+    void for_each(F&& f) const {
+        int n = std::min(used.load(std::memory_order_acquire), SLOT_MASK + 1);
+        for (int index = 0; index < n; index++) {
+            Slot* s = slot(index);
+            if (s && s->live.load(std::memory_order_acquire))
+                f(&s->room);
         }
     }
+};
 
-    Room* room = new Room();
-    room->name = room_name;
-    rooms.push_back(room);
-}
+RoomDirectory rooms;
 
-void handle_join(int fd, int room_id) {
-    Client* c = get_client(fd);
-    if (!c || c->name.empty()) {
-        std::string msg = "ERROR Najpierw ustaw nick\n";
-        send(fd, msg.c_str(), msg.size(), MSG_NOSIGNAL);
-        return;
-    }
+struct LobbySnapshot {
+    uint64_t version;
+    std::string text;
+};
 
-    Room* room = get_room(room_id);
-    if (!room) {
-        std::string msg = "ERROR Pokój nie znaleziony\n";
-        send(fd, msg.c_str(), msg.size(), MSG_NOSIGNAL);
-        return;
-    }
+// Ostatnia zbudowana lista; zapis i odczyt przez std::atomic_store/atomic_load.
+std::shared_ptr<const LobbySnapshot> lobby_cache;
 
-    if (room->client_fds.size() >= 5) {
-        std::string msg = "ERROR Pokój jest pełen (max 5 graczy)\n";
-        send(fd, msg.c_str(), msg.size(), MSG_NOSIGNAL);
-        return;
-    }
+// Rejestr zajętych nicków. Klucz to nick sprowadzony do małych liter (także
+// polskich), więc "Ala" i "ALA" są tym samym graczem. Rejestr jest podzielony
+// na części z osobnymi blokadami, żeby reaktory nie czekały na siebie przy NAME.
+struct NicknameRegistry {
+    static const size_t SHARDS = 16;
 
-    if (room->state == GameState::PLAYING) {
-        std::string msg = "WAITING Gra w trakcie, dołaczysz w nastepnej rundzie\n";
-        send(fd, msg.c_str(), msg.size(), MSG_NOSIGNAL);
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<std::string, Name> names;
+    };
+
+    Shard shards[SHARDS];
+
+    static std::string normalize(const std::string& name) {
+        std::string key;
+        key.reserve(name.size());
+
+        for (size_t i = 0; i < name.size(); i++) {
+            unsigned char ch = name[i];
+
+            if (ch < 0x80) {
+                key += tolower(ch);
+                continue;
+            }
+
+            if ((ch & 0xE0) == 0xC0 && i + 1 < name.size()) {
+                unsigned cp = ((ch & 0x1F) << 6) | ((unsigned char)name[i + 1] & 0x3F);
+
+                switch (cp) {
+                case 0x0104: case 0x0106: case 0x0118: case 0x0141: case 0x0143:
+                case 0x015A: case 0x0179: case 0x017B:
+                    cp += 1;
+                    break;
+                case 0x00D3:
+                    cp = 0x00F3;
+                    break;
+                default:
+                    key += name[i];
+                    continue;
+                }
+
+                key += (char)(0xC0 | (cp >> 6));
+                key += (char)(0x80 | (cp & 0x3F));
+                i++;
+                continue;
+            }
+
+            key += name[i];
+        }
+
+        return key;
+    }
+
+    Shard& shard_for(const std::string& key) {
+        return shards[std::hash<std::string>()(key) % SHARDS];
+    }
+
+    // Sprawdza i rezerwuje nick w jednym kroku; nullptr, gdy jest zajęty.
+    Name reserve(const std::string& name) {
+        std::string key = normalize(name);
+        Shard& shard = shard_for(key);
+
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto result = shard.names.try_emplace(std::move(key));
+        if (!result.second)
+            return nullptr;
+
+        result.first->second = std::make_shared<const std::string>(name);
+        return result.first->second;
+    }
+
+    void release(const Name& name) {
+        if (!name)
+            return;
+
+        std::string key = normalize(*name);
+        Shard& shard = shard_for(key);
+
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.names.find(key);
+        if (it != shard.names.end() && it->second == name)
+            shard.names.erase(it);
+    }
+};
+
+NicknameRegistry nicknames;
+
+std::vector<std::string> word_list = {
+    "PROGRAMOWANIE", "KOMPUTER", "INTERNET", "SERWER", "KLIENT",
+    "ALGORYTM", "SZYFR", "HASLO", "GRACZ",
+    "WISIELEC", "RYWALIZACJA", "SIEC", "ROZGRYWKA", "TURNIEJ",
+    "ZWYCIESTWO", "PORAZKA", "WYTRWALOSC", "INTELIGENCJA", "LOGIKA",
+    "STRATEGIA", "KOMUNIKACJA", "INFORMACJA", "TECHNOLOGIA", "ROZWOJ"
+};
+
+// Słownik haseł: plik z dict_build (opcja -d) albo obraz zbudowany
+// z word_list przy starcie. Reaktory czytają wskaźnik bez blokady;
+// przeładowanie podmienia go i zwalnia stary słownik dopiero po okresie
+// karencji, gdy każdy reaktor zaczął kolejny obieg pętli. Wątek zapytań
+// WORDS czyta słownik dłużej i na ten czas trzyma dictionary_scan_mutex.
+std::atomic<Dictionary*> dictionary{nullptr};
+std::string dictionary_path;
+std::mutex dictionary_scan_mutex;
+
+Leaderboard leaderboard;
+
+
+// Zadania dla innego reaktora (np. przekazanie klienta przy JOIN) trafiają
+// do jego skrzynki i są wykonywane w jego wątku po wybudzeniu przez eventfd.
+void wake(Reactor* r) {
+    uint64_t one = 1;
+    if (write(r->wake_fd, &one, sizeof(one)) < 0 && errno != EAGAIN)
+        LOG_ERROR("Błąd zapisu eventfd", "reactor", r->id, "error", strerror(errno));
+}
+
+void post(Reactor* r, std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(r->inbox_mutex);
+        r->inbox.push_back(std::move(task));
+    }
+
+    wake(r);
+}
+
+void lobby_changed() {
+    lobby_version.fetch_add(1, std::memory_order_acq_rel);
+
+    for (Reactor* r : reactors) {
+        if (r != current_reactor)
+            wake(r);
+    }
+}
+
+void run_inbox(Reactor* r) {
+    uint64_t count;
+    while (read(r->wake_fd, &count, sizeof(count)) > 0) {}
+
+    std::vector<std::function<void()>> tasks;
+    {
+        std::lock_guard<std::mutex> lock(r->inbox_mutex);
+        tasks.swap(r->inbox);
+    }
+
+    for (auto& task : tasks)
+        task();
+}
+
+Client* get_client(int fd) {
+    if (!current_reactor)
+        return nullptr;
+
+    return connections.find(fd, current_reactor->id);
+}
+
+void attach_client(Reactor* r, Client& c) {
+    c.reactor_pos = r->client_fds.size();
+    r->client_fds.push_back(c.fd);
+    connections.slot(c.fd)->reactor.store(r->id, std::memory_order_release);
+}
+
+void detach_client(Reactor* r, Client& c) {
+    int last = r->client_fds.back();
+    r->client_fds[c.reactor_pos] = last;
+    connections.slot(last)->client.reactor_pos = c.reactor_pos;
+    r->client_fds.pop_back();
+}
+
+void schedule_close(Client& c) {
+    if (c.closing)
+        return;
+
+    c.closing = true;
+    current_reactor->closing.push_back(connections.handle(c.fd));
+}
+
+// Połączenia z danymi do odczytu lub nieprzetworzonymi komendami czekają
+// w kolejce reaktora i dostają po jednym przydziale pracy na przebieg pętli.
+void queue_ready(Reactor* r, Client& c) {
+    if (c.queued || c.closing)
+        return;
+
+    c.queued = true;
+    r->ready.push_back(connections.handle(c.fd));
+}
+
+void update_write_interest(Client& c) {
+    bool want = c.output.pending() > 0;
+    if (want == c.want_write)
+        return;
+
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLET | (want ? (uint32_t)EPOLLOUT : 0u);
+    ev.data.fd = c.fd;
+    epoll_ctl(current_reactor->epfd, EPOLL_CTL_MOD, c.fd, &ev);
+    c.want_write = want;
+}
+
+void flush_client(Client& c) {
+    iovec iov[16];
+
+    while (c.output.pending() > 0) {
+        int count = c.output.fill_iov(iov, 16);
+        ssize_t n = writev(c.fd, iov, count);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                schedule_close(c);
+            break;
+        }
+        c.output.consume(n);
+    }
+
+    if (!c.closing)
+        update_write_interest(c);
+}
+
+// Gdy kolejka jest pusta, komunikat jest wysyłany od razu, a do kolejki trafia
+// tylko reszta, której gniazdo nie przyjęło. Klient, który nie odbiera danych,
+// zostaje rozłączony po przekroczeniu OUTPUT_HIGH_WATER albo OUTPUT_LAG_LIMIT
+// zamiast blokować reaktor. Zwraca liczbę bajtów, które trzeba jeszcze zakolejkować.
+size_t try_send_now(Client& c, const std::string& msg) {
+    if (c.closing)
+        return 0;
+
+    current_reactor->metrics.messages_out.add();
+    current_reactor->metrics.bytes_out.add(msg.size());
+
+    if (c.output.pending() > 0)
+        return msg.size();
+
+    ssize_t n;
+    do {
+        n = send(c.fd, msg.data(), msg.size(), MSG_NOSIGNAL);
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+            return msg.size();
+
+        schedule_close(c);
+        return 0;
+    }
+
+    return msg.size() - n;
+}
+
+void enqueue_rest(Client& c, SharedBuffer buf, size_t rest, MessageKind kind, int key) {
+    if (rest == 0 || c.closing)
+        return;
+
+    size_t skip = buf->size() - rest;
+    int dropped = c.output.push(std::move(buf), skip, kind, key);
+    if (dropped > 0)
+        current_reactor->metrics.messages_coalesced.add(dropped);
+
+    if (c.output.pending() > OUTPUT_HIGH_WATER) {
+        LOG_WARN("Klient nie odbiera danych, rozłączam", "fd", c.fd,
+                 "pending", c.output.pending());
+        schedule_close(c);
+        return;
+    }
+
+    auto lag = c.output.lag();
+    if (lag > OUTPUT_LAG_LIMIT) {
+        LOG_WARN("Klient nie nadąża z odbiorem, rozłączam", "fd", c.fd,
+                 "lag_ms", std::chrono::duration_cast<std::chrono::milliseconds>(lag).count(),
+                 "pending", c.output.pending());
+        current_reactor->metrics.laggards_closed.add();
+        schedule_close(c);
+        return;
+    }
+
+    update_write_interest(c);
+}
+
+// kind i key (id pokoju) pozwalają zastąpić niewysłaną starszą wersję tego
+// samego komunikatu zamiast kolejkować obie; zob. MessageKind.
+void queue_send(Client& c, const SharedBuffer& buf, MessageKind kind = MSG_OTHER, int key = 0) {
+    enqueue_rest(c, buf, try_send_now(c, *buf), kind, key);
+}
+
+void queue_send(Client& c, const std::string& msg, MessageKind kind = MSG_OTHER, int key = 0) {
+    size_t rest = try_send_now(c, msg);
+    if (rest > 0)
+        enqueue_rest(c, std::make_shared<const std::string>(msg), rest, kind, key);
+}
+
+void send_to(int fd, const std::string& msg) {
+    Client* c = get_client(fd);
+    if (c)
+        queue_send(*c, msg);
+}
+
+void send_to_room(Room* room, const std::string& msg, MessageKind kind = MSG_OTHER) {
+    SharedBuffer buf = std::make_shared<const std::string>(msg);
+    current_reactor->metrics.room_fanout.observe(room->client_fds.size());
+
+    for (int fd : room->client_fds) {
+        Client* c = get_client(fd);
+        if (c)
+            queue_send(*c, buf, kind, room->id);
+    }
+}
+
+Room* get_room(int room_id) {
+    return rooms.get(room_id);
+}
+
+// Zmiana stanu rundy tylko oznacza pokój; stan jest wysyłany raz na przebieg
+// pętli reaktora, więc kilka ruchów z jednej paczki zdarzeń daje jeden GAME.
+void mark_dirty(Room* room) {
+    if (room->state_dirty || !current_reactor)
+        return;
+
+    room->state_dirty = true;
+    current_reactor->dirty_rooms.push_back(room);
+}
+
+// Pusty pokój jest usuwany, jeśli nikt do niego nie dołączy przez
+// ROOM_IDLE_MS. Dołączenie podbija idle_epoch, więc wcześniejsze zegary
+// tego pokoju nic nie robią. Działa w wątku reaktora-właściciela.
+const int ROOM_IDLE_MS = 60000;
+
+void schedule_reclaim(Room* room) {
+    int id = room->id;
+    uint64_t epoch = ++room->idle_epoch;
+
+    current_reactor->timers.schedule(ROOM_IDLE_MS, [id, epoch]() {
+        Room* room = get_room(id);
+        if (!room || room->idle_epoch != epoch || !room->client_fds.empty() ||
+            room->state == GameState::PLAYING)
+            return;
+
+        LOG_INFO("Usunięto pusty pokój", "room", room->name, "id", id);
+        rooms.remove(room);
+        current_reactor->metrics.rooms_removed.add();
+        lobby_changed();
+    });
+}
+
+void remove_client_from_room(Room* room, int fd) {
+    room->client_fds.erase(
+        std::remove(room->client_fds.begin(), room->client_fds.end(), fd),
+        room->client_fds.end()
+    );
+    room->member_count = room->client_fds.size();
+
+    int index = room->players.find(fd);
+    if (index >= 0)
+        room->players.remove(index);
+
+    room->join_times.erase(fd);
+    lobby_changed();
+
+    if (room->client_fds.empty())
+        schedule_reclaim(room);
+
+    if (room->state == GameState::PLAYING) {
+        room->keyframe_due = true;
+        mark_dirty(room);
+    }
+}
+
+std::string generate_word(const WordCriteria& criteria) {
+    thread_local std::mt19937 gen(std::random_device{}());
+    const Dictionary* dict = dictionary.load();
+    std::string word;
+
+    if (!dict->pick(criteria, gen, word))
+        dict->pick(WordCriteria(), gen, word);
+
+    return word;
+}
+
+// Czeka, aż każdy reaktor zacznie nowy obieg pętli - od tego momentu żaden
+// nie trzyma wskaźnika odczytanego przed podmianą.
+void wait_for_reactors() {
+    std::vector<uint64_t> seen;
+    for (Reactor* r : reactors) {
+        seen.push_back(r->passes.load());
+        wake(r);
+    }
+
+    for (size_t i = 0; i < reactors.size(); i++) {
+        while (reactors[i]->passes.load() == seen[i])
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void reload_dictionary() {
+    if (dictionary_path.empty()) {
+        LOG_WARN("Serwer działa na wbudowanej liście słów - brak pliku do przeładowania");
+        return;
+    }
+
+    Dictionary* fresh = new Dictionary();
+    if (!fresh->open(dictionary_path) || fresh->word_count() == 0) {
+        LOG_ERROR("Niepoprawny plik słownika - zostaje poprzedni", "path", dictionary_path);
+        delete fresh;
+        return;
+    }
+
+    fresh->warm_from(*dictionary.load());
+
+    Dictionary* old = dictionary.exchange(fresh);
+    wait_for_reactors();
+    {
+        std::lock_guard<std::mutex> lock(dictionary_scan_mutex);
+    }
+    delete old;
+
+    LOG_INFO("Przeładowano słownik", "path", dictionary_path, "words", fresh->word_count());
+}
+
+// Wątek przeładowań: SIGHUP jest zablokowany we wszystkich wątkach i odbierany
+// tylko tutaj, więc budowa nowego słownika nie dzieje się w wątku reaktora.
+// RELOAD wysyła sygnał bezpośrednio do tego wątku (reload_thread).
+pthread_t reload_thread;
+
+void reload_loop(sigset_t signals) {
+    int sig;
+    while (sigwait(&signals, &sig) == 0)
+        reload_dictionary();
+}
+
+void init_game(Room* room) {
+    room->state = GameState::PLAYING;
+    lobby_changed();
+    room->current_round++;
+    room->round_epoch++;
+    room->secret_word = generate_word(room->criteria);
+    room->word = compile_word(room->secret_word);
+    room->game_start = time(nullptr);
+    room->round_start = std::chrono::steady_clock::now();
+
+    room->players.clear();
+    current_reactor->metrics.games_started.add();
+
+    for (int fd : room->client_fds) {
+        Client* c = get_client(fd);
+        if (!c)
+            continue;
+
+        room->players.add(fd, c->name);
+    }
+
+    LOG_INFO("Rozpoczęto grę", "room", room->name, "word", room->secret_word,
+             "players", room->players.size());
+}
+
+bool process_guess(Room* room, size_t i, char letter) {
+    RoundPlayers& players = room->players;
+
+    int l = toupper((unsigned char)letter) - 'A';
+    if (l < 0 || l >= 26)
+        return false;
+
+    uint32_t bit = 1u << l;
+    if (players.tried[i] & bit)
+        return false;
+
+    players.tried[i] |= bit;
+
+    uint64_t hits = room->word.positions[l];
+
+    if (hits) {
+        players.revealed[i] |= hits;
+        players.changed[i] |= FIELD_GUESSED | FIELD_PROGRESS;
+
+        if (players.revealed[i] == room->word.full) {
+            auto elapsed = std::chrono::steady_clock::now() - room->round_start;
+            players.finish(i, std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count());
+            players.changed[i] |= FIELD_DONE | FIELD_ACTIVE;
+
+            LOG_INFO("Gracz odgadł hasło", "room", room->name, "nick", *players.name[i],
+                     "ms", players.finish_ms[i]);
+        }
+    } else {
+        players.stage[i]++;
+        players.changed[i] |= FIELD_STAGE | FIELD_WRONG;
+
+        if (players.stage[i] >= 6) {
+            players.flags[i] &= ~PLAYER_ACTIVE;
+            players.changed[i] |= FIELD_ACTIVE;
+            LOG_INFO("Gracz odpadł", "room", room->name, "nick", *players.name[i]);
+        }
+    }
+
+    return true;
+}
+
+bool is_game_finished(Room* room) {
+    time_t now = time(nullptr);
+
+    if (now - room->game_start > room->time_limit) {
+        LOG_INFO("Czas gry wyczerpany", "room", room->name);
+        return true;
+    }
+
+    int active_count = 0;
+
+    for (uint8_t f : room->players.flags)
+        active_count += f == PLAYER_ACTIVE;
+
+    if (active_count <= 1) {
+        LOG_INFO("Gra zakończona", "room", room->name, "active", active_count);
+        return true;
+    }
+
+    return false;
+}
+
+std::string build_ranking(Room* room) {
+    const RoundPlayers& players = room->players;
+
+    // Najpierw odgadnięcia w kolejności zapisanej w trakcie rundy, potem
+    // pozostali gracze pogrupowani według liczby błędów.
+    std::vector<uint32_t> ranked = players.finish_order;
+    size_t finished = ranked.size();
+
+    for (int stage = 0; stage <= 6; stage++) {
+        for (size_t i = 0; i < players.size(); i++) {
+            if (!players.guessed(i) && players.stage[i] == stage)
+                ranked.push_back(i);
+        }
+    }
+
+    std::ostringstream oss;
+    oss << " RANKING - KONIEC GRY \n";
+    oss << "═══════════════════════════\n\n";
+
+    int position = 1;
+
+    for (size_t i = 0; i < ranked.size(); ++i) {
+        uint32_t p = ranked[i];
+        int stage = players.stage[p];
+
+        if (i == 0 || i >= finished ||
+            players.finish_ms[p] != players.finish_ms[ranked[i - 1]])
+            position = i + 1;
+
+        oss << position << ". " << *players.name[p] << "\n";
+
+        if (i < finished) {
+            uint32_t ms = players.finish_ms[p];
+            oss << "      Czas: " << ms / 1000 << "." << std::setfill('0') << std::setw(3)
+                << ms % 1000 << std::setfill(' ') << "s | Błędów: "
+                << stage << "\n";
+        } else {
+            oss << "     DNF";
+            if (stage >= 6) {
+                oss << " (odpadł po " << stage << " błędach)\n";
+            } else {
+                oss << " (nie ukończył w czasie)";
+                if (stage > 0)
+                    oss << " | Błędów: " << stage;
+                oss << "\n";
+            }
+        }
+
+        oss << "\n";
+    }
+
+    oss << "═══════════════════════════\n";
+    oss << "Właściciel może rozpocząć nową grę";
+
+    return oss.str();
+}
+
+std::string player_progress(uint64_t revealed, const std::string& word) {
+    std::string out(word.size(), '_');
+    for (size_t i = 0; i < word.size() && i < CompiledWord::MAX_LENGTH; ++i) {
+        if (revealed & (1ull << i))
+            out[i] = word[i];
+    }
+    return out;
+}
+
+int guessed_count(uint64_t revealed) {
+    return __builtin_popcountll(revealed);
+}
+
+std::string wrong_letters(uint32_t tried, const CompiledWord& word) {
+    std::string out;
+    uint32_t wrong = tried & ~word.letters;
+
+    for (int l = 0; l < 26; l++) {
+        if (wrong & (1u << l))
+            out += (char)('A' + l);
+    }
+    return out;
+}
+
+std::string build_game_state(Room* room) {
+    std::ostringstream oss;
+
+    time_t now = time(nullptr);
+    int time_left = room->time_limit - (now - room->game_start);
+    if (time_left < 0)
+        time_left = 0;
+
+    oss << "GAME "
+        << room->secret_word.length() << " "
+        << time_left << " "
+        << room->players.size();
+
+    const RoundPlayers& players = room->players;
+
+    for (size_t i = 0; i < players.size(); i++) {
+        oss << " " << *players.name[i]
+            << ":" << (int)players.stage[i]
+            << ":" << guessed_count(players.revealed[i])
+            << ":";
+
+        oss << wrong_letters(players.tried[i], room->word);
+
+        oss << ":"
+            << (players.active(i) ? "1" : "0")
+            << ":" << (players.guessed(i) ? "1" : "0")
+            << ":" << player_progress(players.revealed[i], room->secret_word);
+    }
+
+    oss << "\n";
+    return oss.str();
+}
+
+// Jedna linia GAME_DELTA na gracza, z samymi polami zmienionymi od
+// poprzedniego wysłania, np. "GAME_DELTA ala s=2 w=XQ".
+std::string build_game_delta(Room* room) {
+    std::string out;
+
+    const RoundPlayers& players = room->players;
+
+    for (size_t i = 0; i < players.size(); i++) {
+        unsigned changed = players.changed[i];
+        if (!changed)
+            continue;
+
+        out += "GAME_DELTA ";
+        out += *players.name[i];
+
+        if (changed & FIELD_STAGE)
+            out += " s=" + std::to_string(players.stage[i]);
+        if (changed & FIELD_GUESSED)
+            out += " g=" + std::to_string(guessed_count(players.revealed[i]));
+        if (changed & FIELD_WRONG) {
+            out += " w=";
+            out += wrong_letters(players.tried[i], room->word);
+        }
+        if (changed & FIELD_ACTIVE)
+            out += players.active(i) ? " a=1" : " a=0";
+        if (changed & FIELD_DONE)
+            out += players.guessed(i) ? " d=1" : " d=0";
+        if (changed & FIELD_PROGRESS)
+            out += " p=" + player_progress(players.revealed[i], room->secret_word);
+
+        out += "\n";
+    }
+
+    return out;
+}
+
+void send_game_state(Room* room) {
+    std::string msg = build_game_state(room);
+
+    LOG_DEBUG("Wysyłam stan gry", "room", room->name,
+              "state", std::string_view(msg.data(), msg.size() - 1));
+
+    send_to_room(room, msg, MSG_GAME);
+
+    std::fill(room->players.changed.begin(), room->players.changed.end(), 0);
+    room->keyframe_due = false;
+}
+
+// Klienci, którzy wysłali DELTA ON, dostają tylko zmienione pola; pozostali
+// nadal pełną linię GAME. Pełny stan (klatka kluczowa) idzie do wszystkich na
+// starcie rundy, co kilka sekund i po zmianie składu graczy. Klient, który ma
+// jeszcze niewysłane dane, zamiast delty dostaje pełny stan, bo tylko ten może
+// zastąpić w kolejce starsze komunikaty GAME i GAME_DELTA tego pokoju.
+void send_game_update(Room* room) {
+    if (room->keyframe_due) {
+        send_game_state(room);
         return;
     }
 
-    {
-        std::lock_guard<std::mutex> lock(rooms_mutex);
-        remove_client_from_rooms_unlocked(fd);
-        room->client_fds.push_back(fd);
-        room->join_times[fd] = time(nullptr);
+    std::string delta = build_game_delta(room);
+    if (delta.empty())
+        return;
+
+    SharedBuffer delta_buf = std::make_shared<const std::string>(std::move(delta));
+    SharedBuffer full;
+    uint64_t sent = 0;
+
+    for (int fd : room->client_fds) {
+        Client* c = get_client(fd);
+        if (!c)
+            continue;
+
+        sent++;
+        if (c->wants_delta && c->output.pending() == 0) {
+            queue_send(*c, delta_buf, MSG_GAME_DELTA, room->id);
+        } else {
+            if (!full)
+                full = std::make_shared<const std::string>(build_game_state(room));
+            queue_send(*c, full, MSG_GAME, room->id);
+        }
     }
 
-    c->room_id = room_id;
+    current_reactor->metrics.game_fanout.observe(sent);
+    std::fill(room->players.changed.begin(), room->players.changed.end(), 0);
+}
 
-    std::string msg = "JOINED " + std::to_string(room_id) + "\n";
-    send(fd, msg.c_str(), msg.size(), MSG_NOSIGNAL);
+void end_round(Room* room) {
+    room->state = GameState::FINISHED;
+    current_reactor->metrics.games_finished.add();
 
-    send_room_players(room);
-    broadcast_rooms();
+    const RoundPlayers& players = room->players;
+    for (uint32_t i : players.finish_order)
+        leaderboard.record(*players.name[i], players.finish_ms[i], players.stage[i]);
+
+    std::string ranking = build_ranking(room);
+    std::string flat = ranking;
+
+    size_t pos = 0;
+    while ((pos = flat.find('\n', pos)) != std::string::npos) {
+        flat.replace(pos, 1, "|");
+        pos++;
+    }
+
+    room->state = GameState::WAITING;
+    lobby_changed();
+    room->current_round = 0;
+    room->players.clear();
+
+    send_to_room(room, "ROOM_LOBBY\n");
+
+    std::string msg = "RANKING_FULL " + flat + "\n";
+    int id = room->id;
+    current_reactor->timers.schedule(100, [id, msg]() {
+        Room* room = get_room(id);
+        if (room)
+            send_to_room(room, msg);
+    });
 }
 
-void handle_leave(int fd) {
+// Zegary rundy sprawdzają epokę, więc zegar z poprzedniej, już zakończonej
+// rundy jest po prostu ignorowany zamiast odwoływany.
+bool round_current(Room* room, uint64_t epoch) {
+    return room->round_epoch == epoch && room->state == GameState::PLAYING;
+}
+
+// Cykliczny komunikat niesie tylko odliczanie; stan graczy wysyła
+// flush_dirty_rooms zaraz po każdym ruchu.
+void round_tick(Room* room, uint64_t epoch) {
+    if (!round_current(room, epoch))
+        return;
+
+    int time_left = room->time_limit - (time(nullptr) - room->game_start);
+    if (time_left < 0)
+        time_left = 0;
+
+    send_to_room(room, "TIME " + std::to_string(time_left) + "\n", MSG_TIME);
+
+    if (time_left % 5 == 0) {
+        room->keyframe_due = true;
+        mark_dirty(room);
+    }
+
+    current_reactor->timers.schedule(1000, [room, epoch]() { round_tick(room, epoch); });
+}
+
+void start_round(Room* room) {
+    init_game(room);
+
+    uint64_t epoch = room->round_epoch;
+    TimerWheel& timers = current_reactor->timers;
+
+    send_game_state(room);
+    timers.schedule(1000, [room, epoch]() { round_tick(room, epoch); });
+
+    timers.schedule(room->time_limit * 1000, [room, epoch]() {
+        if (!round_current(room, epoch))
+            return;
+
+        LOG_INFO("Czas gry wyczerpany", "room", room->name);
+
+        send_game_state(room);
+        end_round(room);
+    });
+}
+
+void flush_dirty_rooms(Reactor* r) {
+    std::vector<Room*> dirty;
+    dirty.swap(r->dirty_rooms);
+
+    for (Room* room : dirty) {
+        room->state_dirty = false;
+
+        if (room->state != GameState::PLAYING)
+            continue;
+
+        send_game_update(room);
+
+        if (is_game_finished(room))
+            end_round(room);
+    }
+}
+
+void send_room_players(Room* room) {
+    std::ostringstream oss;
+    oss << "ROOM_PLAYERS";
+
+    for (int fd : room->client_fds) {
+        Client* c = get_client(fd);
+        if (c && c->name)
+            oss << " " << *c->name;
+    }
+
+    oss << "\n";
+    send_to_room(room, oss.str());
+}
+
+bool in_lobby(const Client& c) {
+    return c.name && c.room_id == -1;
+}
+
+// Pełna lista pokoi do wysłania; przebudowywana najwyżej raz na wersję.
+// Aktualna lista jest zwracana bez blokady, jako wskaźnik do tekstu
+// współdzielący własność z całą migawką.
+SharedBuffer lobby_snapshot(uint64_t& version) {
+    uint64_t current = lobby_version.load(std::memory_order_acquire);
+    std::shared_ptr<const LobbySnapshot> snapshot = std::atomic_load(&lobby_cache);
+
+    if (!snapshot || snapshot->version != current) {
+        std::lock_guard<std::mutex> lock(lobby_mutex);
+
+        current = lobby_version.load(std::memory_order_acquire);
+        snapshot = std::atomic_load(&lobby_cache);
+        if (!snapshot || snapshot->version != current) {
+            std::ostringstream list;
+            int listed = 0;
+
+            rooms.for_each([&](Room* room) {
+                list << " " << room->name
+                     << ":" << room->member_count
+                     << ":" << (room->state == GameState::PLAYING ? "1" : "0")
+                     << ":" << room->id;
+                listed++;
+            });
+
+            std::ostringstream oss;
+            oss << "ROOMS " << listed << list.str() << "\n";
+            auto fresh = std::make_shared<LobbySnapshot>();
+            fresh->version = current;
+            fresh->text = oss.str();
+            snapshot = fresh;
+            std::atomic_store(&lobby_cache, snapshot);
+        }
+    }
+
+    version = snapshot->version;
+    return SharedBuffer(snapshot, &snapshot->text);
+}
+
+void send_lobby(Client& c) {
+    uint64_t version;
+    queue_send(c, lobby_snapshot(version), MSG_ROOMS);
+}
+
+// Wysyła aktualną listę pokoi klientom reaktora, którzy są w lobby, o ile
+// od ostatniego razu zmieniła się jej wersja. Wszyscy dostają ten sam bufor.
+void publish_lobby(Reactor* r) {
+    if (lobby_version.load(std::memory_order_acquire) == r->lobby_version)
+        return;
+
+    uint64_t version;
+    SharedBuffer payload = lobby_snapshot(version);
+    r->lobby_version = version;
+    uint64_t sent = 0;
+
+    for (int fd : r->client_fds) {
+        Client* c = connections.find(fd, r->id);
+        if (c && in_lobby(*c)) {
+            queue_send(*c, payload, MSG_ROOMS);
+            sent++;
+        }
+    }
+
+    if (sent > 0)
+        r->metrics.lobby_fanout.observe(sent);
+}
+
+void handle_name(int fd, const std::string& name) {
     Client* c = get_client(fd);
     if (!c)
         return;
 
-    int old_room = c->room_id;
-    Room* room = get_room(old_room);
+    Name reserved = name.empty() ? nullptr : nicknames.reserve(name);
+    if (!reserved) {
+        std::string msg = "ERROR Nickname already taken: " + name + "\n";
+        send_to(fd, msg);
+        return;
+    }
 
-    if (room && room->state == GameState::PLAYING) {
-        for (auto& p : room->players) {
-            if (p.fd == fd) {
-                p.active = false;
-                break;
-            }
-        }
+    nicknames.release(c->name);
+    c->name = std::move(reserved);
+    c->join_time = time(nullptr);
+
+    std::string msg = "OK Nickname set to " + name + "\n";
+    send_to(fd, msg);
+
+    if (c->room_id == -1)
+        send_lobby(*c);
+}
+
+void handle_create(int fd, const std::string& room_name) {
+    Client* c = get_client(fd);
+    if (!c || !c->name) {
+        std::string msg = "ERROR Najpierw ustaw nick\n";
+        send_to(fd, msg);
+        return;
     }
 
-    remove_client_from_rooms(fd);
+    bool busy;
+    Room* room = rooms.add(room_name, busy);
+
+    if (!room) {
+        std::string msg = busy ? "ERROR Pokój o takiej nazwie istnieje\n"
+                               : "ERROR Osiągnięto limit pokoi\n";
+        send_to(fd, msg);
+        return;
+    }
+
+    current_reactor->metrics.rooms_created.add();
+
+    int id = room->id;
+    post(reactors[room->owner], [id]() {
+        Room* created = get_room(id);
+        if (created && created->client_fds.empty())
+            schedule_reclaim(created);
+    });
+
+    lobby_changed();
+}
+
+void leave_room(Client* c) {
+    Room* room = get_room(c->room_id);
     c->room_id = -1;
 
-    std::string msg = "LEFT\n";
-    send(fd, msg.c_str(), msg.size(), MSG_NOSIGNAL);
+    if (!room)
+        return;
+
+    remove_client_from_room(room, c->fd);
+
+    if (!room->client_fds.empty())
+        send_room_players(room);
+}
+
+// Pokój żyje na jednym reaktorze, więc klient dołączający do pokoju z innego
+// reaktora jest tam przenoszony razem z nieprzetworzonymi jeszcze komendami.
+void handoff_client(int fd, Reactor* to) {
+    Reactor* from = current_reactor;
 
-    Room* updated = get_room(old_room);
-    if (updated && !updated->client_fds.empty())
-        send_room_players(updated);
+    Client* c = get_client(fd);
+    if (!c)
+        return;
+
+    if (c->room_id != -1)
+        leave_room(c);
+
+    detach_client(from, *c);
+    epoll_ctl(from->epfd, EPOLL_CTL_DEL, fd, nullptr);
+
+    ClientHandle h = connections.handle(fd);
+    connections.transfer(h, -1);
+
+    post(to, [to, h]() {
+        Client* adopted = connections.transfer(h, to->id);
+        if (!adopted)
+            return;
+
+        attach_client(to, *adopted);
+        adopted->want_write = adopted->output.pending() > 0;
+        adopted->queued = false;
+
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLET | (adopted->want_write ? (uint32_t)EPOLLOUT : 0u);
+        ev.data.fd = h.fd;
+        epoll_ctl(to->epfd, EPOLL_CTL_ADD, h.fd, &ev);
+
+        queue_ready(to, *adopted);
+    });
+}
+
+// Odmowa wejścia do pokoju pełnego albo w trakcie rundy. Przed przekazaniem
+// klienta do reaktora pokoju sprawdzana na licznikach atomowych, żeby
+// odrzucony JOIN nie wyrzucał gracza z obecnego pokoju.
+bool refuse_join(int fd, size_t members, GameState state) {
+    if (members >= 5) {
+        std::string msg = "ERROR Pokój jest pełen (max 5 graczy)\n";
+        send_to(fd, msg);
+        return true;
+    }
+
+    if (state == GameState::PLAYING) {
+        std::string msg = "WAITING Gra w trakcie, dołaczysz w nastepnej rundzie\n";
+        send_to(fd, msg);
+        return true;
+    }
+
+    return false;
+}
+
+void handle_join(int fd, int room_id) {
+    Client* c = get_client(fd);
+    if (!c || !c->name) {
+        std::string msg = "ERROR Najpierw ustaw nick\n";
+        send_to(fd, msg);
+        return;
+    }
+
+    Room* room = get_room(room_id);
+    if (!room) {
+        std::string msg = "ERROR Pokój nie znaleziony\n";
+        send_to(fd, msg);
+        return;
+    }
+
+    if (refuse_join(fd, room->client_fds.size(), room->state))
+        return;
+
+    Room* old_room = get_room(c->room_id);
+    if (old_room)
+        remove_client_from_room(old_room, fd);
+
+    room->client_fds.push_back(fd);
+    room->member_count = room->client_fds.size();
+    room->idle_epoch++;
+    room->join_times[fd] = time(nullptr);
+
+    c->room_id = room_id;
+
+    std::string msg = "JOINED " + std::to_string(room_id) + "\n";
+    send_to(fd, msg);
+
+    send_room_players(room);
+    lobby_changed();
+}
+
+void handle_leave(int fd) {
+    Client* c = get_client(fd);
+    if (!c)
+        return;
+
+    bool was_in_room = c->room_id != -1;
+    leave_room(c);
 
-    broadcast_rooms();
+    std::string msg = "LEFT\n";
+    send_to(fd, msg);
+
+    if (!was_in_room)
+        send_lobby(*c);
 }
 
 void handle_start(int fd) {
@@ -630,7 +2021,7 @@ void handle_start(int fd) {
 
     if (room->client_fds.size() < 2) {
         std::string msg = "ERROR Potrzeba conajmniej 2 graczy\n";
-        send(fd, msg.c_str(), msg.size(), MSG_NOSIGNAL);
+        send_to(fd, msg);
         return;
     }
 
@@ -648,297 +2039,951 @@ void handle_start(int fd) {
     if (owner_fd != fd) {
         Client* owner = get_client(owner_fd);
         std::string msg = owner
-            ? "ERROR Tylko " + owner->name + " może rozpoczać grę\n"
+            ? "ERROR Tylko " + *owner->name + " może rozpoczać grę\n"
             : "ERROR Tylko gracz będący najdłużej w pokoju może rozpocząć grę\n";
-        send(fd, msg.c_str(), msg.size(), MSG_NOSIGNAL);
+        send_to(fd, msg);
+        return;
+    }
+
+    start_round(room);
+}
+
+void handle_guess(int fd, char letter) {
+    Client* c = get_client(fd);
+    if (!c || c->room_id == -1)
+        return;
+
+    Room* room = get_room(c->room_id);
+    if (!room || room->state != GameState::PLAYING)
+        return;
+
+    int i = room->players.find(fd);
+    if (i >= 0 && room->players.flags[i] == PLAYER_ACTIVE && process_guess(room, i, letter))
+        mark_dirty(room);
+}
+
+void handle_ready(int fd) {
+    Client* c = get_client(fd);
+    if (!c)
+        return;
+
+    c->ready_for_next = true;
+
+    Room* room = get_room(c->room_id);
+    if (!room || room->state != GameState::FINISHED)
+        return;
+
+    for (int fd2 : room->client_fds) {
+        Client* p = get_client(fd2);
+        if (p && !p->ready_for_next)
+            return;
+    }
+
+    for (int fd2 : room->client_fds) {
+        Client* p = get_client(fd2);
+        if (p)
+            p->ready_for_next = false;
+    }
+
+    start_round(room);
+}
+
+bool is_space(char ch) {
+    return ch == ' ' || ch == '\t' || ch == '\r';
+}
+
+std::string_view trim_left(std::string_view s) {
+    size_t i = 0;
+    while (i < s.size() && is_space(s[i]))
+        i++;
+    return s.substr(i);
+}
+
+std::string_view next_token(std::string_view& rest) {
+    rest = trim_left(rest);
+
+    size_t i = 0;
+    while (i < rest.size() && !is_space(rest[i]))
+        i++;
+
+    std::string_view token = rest.substr(0, i);
+    rest = rest.substr(i);
+    return token;
+}
+
+bool iequals(std::string_view a, const char* b) {
+    size_t i = 0;
+    for (; i < a.size() && b[i]; i++) {
+        if (toupper((unsigned char)a[i]) != b[i])
+            return false;
+    }
+    return i == a.size() && !b[i];
+}
+
+// Maski liter z argumentu "AK-QX": litery przed '-' hasło musi zawierać,
+// litery po nim są wykluczone. Polskie znaki są zamieniane jak w słowniku.
+bool parse_letter_sets(std::string_view arg, uint32_t& letters, uint32_t& excluded) {
+    size_t dash = arg.find('-');
+    std::string_view parts[2] = {arg.substr(0, dash),
+                                 dash == std::string_view::npos ? "" : arg.substr(dash + 1)};
+    uint32_t* masks[2] = {&letters, &excluded};
+
+    for (int i = 0; i < 2; i++) {
+        if (parts[i].empty())
+            continue;
+
+        std::string normalized = normalize_word(std::string(parts[i]));
+        if (normalized.empty())
+            return false;
+        *masks[i] = word_letters(normalized);
+    }
+
+    return (letters & excluded) == 0;
+}
+
+std::string show_letter_sets(uint32_t letters, uint32_t excluded) {
+    if (!letters && !excluded)
+        return "*";
+
+    std::string out;
+    for (int i = 0; i < 26; i++)
+        if (letters & (1u << i))
+            out += (char)('A' + i);
+    if (excluded) {
+        out += '-';
+        for (int i = 0; i < 26; i++)
+            if (excluded & (1u << i))
+                out += (char)('A' + i);
+    }
+    return out;
+}
+
+// Kryteria WORDS czekające na sprawdzenie w słowniku.
+struct WordsQuery {
+    Reactor* reactor;
+    ClientHandle client;
+    int room_id;
+    WordCriteria criteria;
+    std::string reply;
+};
+
+std::mutex words_mutex;
+std::condition_variable words_wake;
+std::vector<WordsQuery> words_queue;
+
+// Wynik sprawdzenia kryteriów; w wątku reaktora pokoju.
+void apply_words(const WordsQuery& q, bool found) {
+    Client* c = connections.valid(q.client) ? get_client(q.client.fd) : nullptr;
+    if (!c)
+        return;
+
+    if (!found) {
+        send_to(c->fd, "ERROR Brak haseł spełniających kryteria\n");
         return;
     }
 
-    init_game(room);
+    Room* room = get_room(q.room_id);
+    if (!room || c->room_id != q.room_id || room->state != GameState::WAITING)
+        return;
+
+    room->criteria = q.criteria;
+    send_to_room(room, q.reply);
+}
 
-    if (room->game_thread)
-        delete room->game_thread;
+// Wątek zapytań WORDS: warunku na litery indeks słownika nie zawęża, a
+// pierwszy przegląd zakresów przy milionach haseł trwa milisekundy, których
+// nie może stracić reaktor z tysiącami klientów. Wynik wraca do reaktora
+// pokoju przez jego skrzynkę; słownik zapamiętuje go dla kolejnych zapytań.
+void words_loop() {
+    std::vector<WordsQuery> batch;
+    std::unique_lock<std::mutex> lock(words_mutex);
+
+    while (true) {
+        words_wake.wait(lock, []() { return !words_queue.empty(); });
+        batch.swap(words_queue);
+        lock.unlock();
+
+        for (const WordsQuery& q : batch) {
+            bool found;
+            {
+                std::lock_guard<std::mutex> hold(dictionary_scan_mutex);
+                found = dictionary.load()->count(q.criteria) > 0;
+            }
+            post(q.reactor, [q, found]() { apply_words(q, found); });
+        }
 
-    room->game_thread = new std::thread(game_loop, room);
-    room->game_thread->detach();
+        batch.clear();
+        lock.lock();
+    }
 }
 
-void handle_guess(int fd, char letter) {
+// WORDS <trudność|*> [długość|*] [różne_litery|*] [litery|*] - kryteria haseł
+// kolejnych rund w pokoju. Zmiana jest odrzucana, gdy słownik nie ma
+// pasującego hasła; warunek na litery sprawdza words_loop.
+void handle_words(int fd, std::string_view args) {
     Client* c = get_client(fd);
     if (!c || c->room_id == -1)
         return;
 
     Room* room = get_room(c->room_id);
-    if (!room || room->state != GameState::PLAYING)
+    if (!room || room->state != GameState::WAITING)
         return;
 
-    for (auto& p : room->players) {
-        if (p.fd == fd && p.active && !p.guessed_word) {
-            process_guess(room, p, letter);
-            break;
+    int values[3] = {-1, -1, -1};
+
+    for (int& v : values) {
+        std::string_view arg = next_token(args);
+        if (arg.empty() || arg == "*")
+            continue;
+
+        if (std::from_chars(arg.data(), arg.data() + arg.size(), v).ec != std::errc() || v < 0) {
+            send_to(fd, "ERROR Niepoprawne kryteria haseł\n");
+            return;
         }
     }
-}
 
-void handle_ready(int fd) {
-    Client* c = get_client(fd);
-    if (!c)
+    WordCriteria criteria;
+    criteria.difficulty = values[0];
+    criteria.length = values[1];
+    criteria.distinct = values[2];
+
+    std::string_view letters = next_token(args);
+    if (!letters.empty() && letters != "*" &&
+        !parse_letter_sets(letters, criteria.letters, criteria.excluded)) {
+        send_to(fd, "ERROR Niepoprawne kryteria haseł\n");
         return;
+    }
 
-    c->ready_for_next = true;
+    auto show = [](int v) { return v < 0 ? std::string("*") : std::to_string(v); };
+    WordsQuery q{current_reactor, connections.handle(fd), room->id, criteria,
+                 "WORDS " + show(values[0]) + " " + show(values[1]) + " " +
+                 show(values[2]) + " " +
+                 show_letter_sets(criteria.letters, criteria.excluded) + "\n"};
 
-    Room* room = get_room(c->room_id);
-    if (!room || room->state != GameState::FINISHED)
-        return;
+    const Dictionary* dict = dictionary.load();
 
-    for (int fd2 : room->client_fds) {
-        Client* p = get_client(fd2);
-        if (p && !p->ready_for_next)
-            return;
+    if (!criteria.has_letters()) {
+        apply_words(q, dict->count(criteria) > 0);
+        return;
     }
 
-    for (int fd2 : room->client_fds) {
-        Client* p = get_client(fd2);
-        if (p)
-            p->ready_for_next = false;
+    if (auto matches = dict->cached_matches(criteria)) {
+        apply_words(q, matches->total > 0);
+        return;
     }
 
-    init_game(room);
-    room->game_thread = new std::thread(game_loop, room);
-    room->game_thread->detach();
+    {
+        std::lock_guard<std::mutex> lock(words_mutex);
+        words_queue.push_back(std::move(q));
+    }
+    words_wake.notify_one();
 }
 
-void process_client_data(int fd, const std::string& data) {
-    std::istringstream iss(data);
-    std::string line;
+// RELOAD - przeładowanie słownika jak po SIGHUP; tylko z połączeń lokalnych.
+void handle_reload(int fd) {
+    sockaddr_in addr{};
+    socklen_t len = sizeof(addr);
 
-    while (std::getline(iss, line)) {
-        if (line.empty())
-            continue;
+    if (getpeername(fd, (sockaddr*)&addr, &len) < 0 || addr.sin_family != AF_INET ||
+        (ntohl(addr.sin_addr.s_addr) >> 24) != 127) {
+        send_to(fd, "ERROR RELOAD dostępne tylko lokalnie\n");
+        return;
+    }
 
-        std::istringstream ls(line);
-        std::string cmd;
-        ls >> cmd;
+    pthread_kill(reload_thread, SIGHUP);
+    send_to(fd, "OK Reloading dictionary\n");
+}
 
-        std::transform(cmd.begin(), cmd.end(), cmd.begin(), ::toupper);
+int command_index(std::string_view cmd) {
+    for (int i = 0; i < COMMAND_COUNT - 1; i++) {
+        if (iequals(cmd, COMMAND_NAMES[i]))
+            return i;
+    }
 
-        if (cmd == "NAME") {
-            std::string name;
-            ls >> name;
-            handle_name(fd, name);
-        }
-        else if (cmd == "CREATE") {
-            std::string room;
-            std::getline(ls >> std::ws, room);
-            handle_create(fd, room);
-        }
-        else if (cmd == "JOIN") {
-            int id;
-            if (ls >> id)
-                handle_join(fd, id);
-        }
-        else if (cmd == "LEAVE") {
-            handle_leave(fd);
-        }
-        else if (cmd == "START") {
-            handle_start(fd);
-        }
-        else if (cmd == "GUESS") {
-            char c;
-            if (ls >> c && isalpha(c))
-                handle_guess(fd, c);
-        }
-        else if (cmd == "READY") {
-            handle_ready(fd);
-        }
-        else if (cmd == "CHAT") {
-            std::string msg;
-            std::getline(ls >> std::ws, msg);
+    return COMMAND_COUNT - 1;
+}
 
+// Zwraca false, gdy klient został przekazany do innego reaktora - linia
+// zostaje wtedy w jego buforze i wykona ją reaktor docelowy.
+bool process_command(int fd, std::string_view line) {
+    std::string_view rest = line;
+    std::string_view cmd = next_token(rest);
+
+    if (cmd.empty())
+        return true;
+
+    if (iequals(cmd, "GUESS")) {
+        rest = trim_left(rest);
+        if (!rest.empty() && isalpha((unsigned char)rest[0]))
+            handle_guess(fd, rest[0]);
+    }
+    else if (iequals(cmd, "NAME")) {
+        handle_name(fd, std::string(next_token(rest)));
+    }
+    else if (iequals(cmd, "CREATE")) {
+        handle_create(fd, std::string(trim_left(rest)));
+    }
+    else if (iequals(cmd, "JOIN")) {
+        std::string_view arg = next_token(rest);
+        int id;
+        if (std::from_chars(arg.data(), arg.data() + arg.size(), id).ec == std::errc()) {
             Client* c = get_client(fd);
-            if (c && c->room_id != -1) {
-                Room* room = get_room(c->room_id);
-                if (room) {
-                    std::string out = "CHAT " + c->name + ": " + msg + "\n";
-                    for (int pfd : room->client_fds)
-                        send(pfd, out.c_str(), out.size(), MSG_NOSIGNAL);
-                }
+            Room* room = get_room(id);
+
+            if (c && c->name && room && room->owner != current_reactor->id) {
+                if (refuse_join(fd, room->member_count.load(), room->state.load()))
+                    return true;
+
+                c->rate.prepaid = true;
+                handoff_client(fd, reactors[room->owner]);
+                return false;
             }
+
+            handle_join(fd, id);
         }
-        else if (cmd == "REFRESH") {
-            broadcast_rooms();
+    }
+    else if (iequals(cmd, "LEAVE")) {
+        handle_leave(fd);
+    }
+    else if (iequals(cmd, "START")) {
+        handle_start(fd);
+    }
+    else if (iequals(cmd, "READY")) {
+        handle_ready(fd);
+    }
+    else if (iequals(cmd, "WORDS")) {
+        handle_words(fd, rest);
+    }
+    else if (iequals(cmd, "RELOAD")) {
+        handle_reload(fd);
+    }
+    else if (iequals(cmd, "LEADERBOARD")) {
+        Client* c = get_client(fd);
+        if (c)
+            queue_send(*c, leaderboard.reply(iequals(next_token(rest), "DAY")));
+    }
+    else if (iequals(cmd, "CHAT")) {
+        std::string_view msg = trim_left(rest);
+
+        Client* c = get_client(fd);
+        if (c && c->room_id != -1) {
+            Room* room = get_room(c->room_id);
+            if (room) {
+                std::string out = "CHAT " + *c->name + ": ";
+                out.append(msg.data(), msg.size());
+                out += "\n";
+                send_to_room(room, out);
+            }
         }
-        else {
-            std::string err = "ERROR Unknown command: " + cmd + "\n";
-            send(fd, err.c_str(), err.size(), MSG_NOSIGNAL);
+    }
+    else if (iequals(cmd, "DELTA")) {
+        Client* c = get_client(fd);
+        if (c)
+            c->wants_delta = iequals(next_token(rest), "ON");
+    }
+    else if (iequals(cmd, "REFRESH")) {
+        Client* c = get_client(fd);
+        if (c)
+            send_lobby(*c);
+    }
+    else {
+        std::string err = "ERROR Unknown command: ";
+        for (char ch : cmd)
+            err += toupper((unsigned char)ch);
+        err += "\n";
+        send_to(fd, err);
+    }
+
+    return true;
+}
+
+// Odrzucona komenda nie jest wykonywana. Odpowiedź to jeden wspólny bufor,
+// wysyłany tylko raz na serię odrzuceń danej klasy, więc zalewanie serwera
+// komendami nie zwiększa ruchu wychodzącego.
+void reject_command(Client& c, int cls) {
+    static const SharedBuffer reply =
+        std::make_shared<const std::string>("ERROR Zbyt wiele komend, zwolnij\n");
+
+    current_reactor->metrics.commands_limited[cls].add();
+
+    if (c.rate.rejected & (1 << cls))
+        return;
+
+    c.rate.rejected |= 1 << cls;
+    LOG_DEBUG("Przekroczony limit komend", "fd", c.fd, "class", rate_limits[cls].name);
+    queue_send(c, reply);
+}
+
+// Wykonuje buforowane komendy klienta, najwyżej budget (zmniejszany o każdą
+// wykonaną komendę).
+void process_client_data(int fd, int& budget) {
+    while (budget > 0) {
+        Client* c = get_client(fd);
+        if (!c)
+            return;
+
+        std::string_view line;
+        if (!c->input.peek_line(line))
+            return;
+
+        size_t consumed = line.size() + 1;
+        if (!line.empty() && line.back() == '\r')
+            line.remove_suffix(1);
+
+        std::string_view rest = line;
+        ReactorMetrics& metrics = current_reactor->metrics;
+        int command = command_index(next_token(rest));
+        metrics.messages_in.add();
+
+        auto started = std::chrono::steady_clock::now();
+        int64_t now_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            started.time_since_epoch()).count();
+
+        int refused = -1;
+        if (c->rate.prepaid)
+            c->rate.prepaid = false;
+        else
+            refused = c->rate.admit(COMMAND_RATE_CLASS[command], now_us);
+
+        if (refused >= 0) {
+            reject_command(*c, refused);
+            budget--;
+            c->input.consume(consumed);
+            continue;
         }
+
+        LatencyHistogram& latency = metrics.command_latency[command];
+        bool more = process_command(fd, line);
+        latency.observe(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - started).count());
+
+        budget--;
+        if (!more)
+            return;
+
+        c = get_client(fd);
+        if (c)
+            c->input.consume(consumed);
     }
 }
 
-int main() {
+int create_listen_socket(int port) {
     int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
     if (listen_fd < 0) {
         perror("socket");
-        return 1;
+        return -1;
     }
 
     int opt = 1;
     setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    if (setsockopt(listen_fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
+        perror("setsockopt SO_REUSEPORT");
+        close(listen_fd);
+        return -1;
+    }
 
     sockaddr_in addr{};
     addr.sin_family = AF_INET;
-    addr.sin_port = htons(5000);
+    addr.sin_port = htons(port);
     addr.sin_addr.s_addr = INADDR_ANY;
 
     if (bind(listen_fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
         perror("bind");
-        return 1;
+        close(listen_fd);
+        return -1;
     }
 
     if (listen(listen_fd, 10) < 0) {
         perror("listen");
-        return 1;
+        close(listen_fd);
+        return -1;
     }
 
     int flags = fcntl(listen_fd, F_GETFL, 0);
     fcntl(listen_fd, F_SETFL, flags | O_NONBLOCK);
 
-    int epfd = epoll_create1(0);
-    if (epfd < 0) {
-        perror("epoll_create1");
-        return 1;
+    return listen_fd;
+}
+
+void disconnect_client(int fd) {
+    Reactor* r = current_reactor;
+
+    Client* c = get_client(fd);
+    if (!c)
+        return;
+
+    Room* room = get_room(c->room_id);
+    if (room)
+        remove_client_from_room(room, fd);
+
+    nicknames.release(c->name);
+    detach_client(r, *c);
+    connections.erase(fd);
+    r->metrics.connections_closed.add();
+
+    epoll_ctl(r->epfd, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+}
+
+void close_pending(Reactor* r) {
+    while (!r->closing.empty()) {
+        std::vector<ClientHandle> handles;
+        handles.swap(r->closing);
+
+        for (ClientHandle h : handles) {
+            if (connections.valid(h))
+                disconnect_client(h.fd);
+        }
     }
+}
 
-    epoll_event ev{};
-    ev.events = EPOLLIN | EPOLLET;
-    ev.data.fd = listen_fd;
-    epoll_ctl(epfd, EPOLL_CTL_ADD, listen_fd, &ev);
+// Przydział pracy dla połączenia na jeden przebieg pętli. Klient, który
+// przysyła dane szybciej, niż są obsługiwane, nie blokuje reaktora: po
+// wyczerpaniu przydziału wraca na koniec kolejki, a reszta danych czeka
+// w gnieździe.
+const size_t READ_BUDGET = 16384;
+const int COMMAND_BUDGET = 64;
 
-    epoll_event events[10];
+// Zwraca true, gdy zostały dane albo komendy do obsłużenia.
+bool serve_client(int fd) {
+    size_t bytes = READ_BUDGET;
+    int commands = COMMAND_BUDGET;
 
-    std::cout << "Serwer nasłuchuje na porcie 5000..." << std::endl;
-    //std::cout << "Dostępne komendy: NAME, CREATE, JOIN, LEAVE, START, GUESS, READY" << std::endl;
+    while (true) {
+        process_client_data(fd, commands);
+
+        Client* c = get_client(fd);
+        if (!c || c->closing)
+            return false;
+
+        if (commands == 0 || bytes == 0)
+            return true;
+
+        LineBuffer& in = c->input;
+        in.prepare();
+
+        if (in.space() == 0) {
+            in.compact();
+
+            if (in.space() == 0) {
+                std::string err = "ERROR Line too long\n";
+                send_to(fd, err);
+                in.clear();
+            }
+        }
+
+        int len = recv(fd, in.tail(), std::min(in.space(), bytes), 0);
+
+        if (len == 0) {
+            LOG_INFO("Klient rozłączony", "fd", fd);
+            disconnect_client(fd);
+            return false;
+        }
+
+        if (len < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return false;
+
+            disconnect_client(fd);
+            return false;
+        }
+
+        in.commit(len);
+        bytes -= len;
+        current_reactor->metrics.bytes_in.add(len);
+    }
+}
+
+// Każde gotowe połączenie dostaje jeden przydział; te z nadmiarem pracy
+// trafiają na koniec kolejki i czekają na kolejny przebieg.
+void serve_ready(Reactor* r) {
+    size_t count = r->ready.size();
+
+    for (size_t i = 0; i < count; i++) {
+        ClientHandle h = r->ready.front();
+        r->ready.pop_front();
+
+        Client* c = connections.valid(h) ? connections.find(h.fd, r->id) : nullptr;
+        if (!c)
+            continue;
+
+        c->queued = false;
+        if (serve_client(h.fd)) {
+            c = get_client(h.fd);
+            if (c)
+                queue_ready(r, *c);
+        }
+    }
+}
+
+// Ustawia timerfd reaktora na najbliższy termin w kole zegarów. Bez zegarów
+// timer jest wyłączony i reaktor śpi w epoll_wait do pierwszego zdarzenia.
+void arm_timer(Reactor* r) {
+    uint64_t tick = r->timers.next_tick();
+    if (tick == r->armed_tick)
+        return;
+
+    r->armed_tick = tick;
+
+    itimerspec spec{};
+    if (tick) {
+        auto deadline = r->timers.origin + std::chrono::milliseconds(tick * TimerWheel::TICK_MS);
+        int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            deadline.time_since_epoch()).count();
+        spec.it_value.tv_sec = ns / 1000000000;
+        spec.it_value.tv_nsec = ns % 1000000000;
+    }
+
+    timerfd_settime(r->timer_fd, TFD_TIMER_ABSTIME, &spec, nullptr);
+}
+
+void reactor_loop(Reactor* r) {
+    current_reactor = r;
+
+    epoll_event ev{};
+    epoll_event events[64];
 
     while (true) {
-        int n = epoll_wait(epfd, events, 10, 100);
+        r->passes.fetch_add(1);
+        int n = epoll_wait(r->epfd, events, 64, r->ready.empty() ? -1 : 0);
+
+        // Po długim czekaniu w epoll_wait koło stoi na ticku sprzed uśpienia;
+        // zegary ustawiane przez komendy liczą się od now_tick, więc trzeba go
+        // dogonić przed obsługą zdarzeń.
+        r->timers.advance();
 
         for (int i = 0; i < n; i++) {
             int fd = events[i].data.fd;
 
-            if (fd == listen_fd) {
+            if (fd == r->wake_fd) {
+                run_inbox(r);
+                continue;
+            }
+
+            if (fd == r->timer_fd) {
+                uint64_t expirations;
+                while (read(r->timer_fd, &expirations, sizeof(expirations)) > 0) {}
+                r->armed_tick = 0;
+                continue;
+            }
+
+            if (fd == r->listen_fd) {
                 while (true) {
-                    int cfd = accept(listen_fd, nullptr, nullptr);
+                    int cfd = accept(r->listen_fd, nullptr, nullptr);
                     if (cfd < 0) {
                         if (errno == EAGAIN || errno == EWOULDBLOCK)
                             break;
-                        perror("accept");
+                        LOG_ERROR("Błąd accept", "reactor", r->id, "error", strerror(errno));
                         break;
                     }
 
                     int cflags = fcntl(cfd, F_GETFL, 0);
                     fcntl(cfd, F_SETFL, cflags | O_NONBLOCK);
 
-                    {
-                        std::lock_guard<std::mutex> lock(clients_mutex);
-                        clients.push_back({cfd, -1, "", time(nullptr), false});
+                    Client* c = connections.insert(cfd, r->id);
+                    if (!c) {
+                        close(cfd);
+                        continue;
                     }
+                    attach_client(r, *c);
+                    r->metrics.connections_opened.add();
 
                     ev.events = EPOLLIN | EPOLLET;
                     ev.data.fd = cfd;
-                    epoll_ctl(epfd, EPOLL_CTL_ADD, cfd, &ev);
+                    epoll_ctl(r->epfd, EPOLL_CTL_ADD, cfd, &ev);
 
-                    std::cout << "Nowy klient: fd=" << cfd << std::endl;
+                    LOG_INFO("Nowy klient", "fd", cfd, "reactor", r->id);
 
                     std::string welcome =
                         "WELCOME Please set your nickname with: NAME <nickname>\n";
-                    send(cfd, welcome.c_str(), welcome.size(), MSG_NOSIGNAL);
+                    send_to(cfd, welcome);
                 }
                 continue;
             }
 
-            char buffer[4096];
-            std::string data;
-
-            while (true) {
-                int len = recv(fd, buffer, sizeof(buffer) - 1, 0);
-
-                if (len == 0) {
-                    std::cout << "Klient rozłączony: fd=" << fd << std::endl;
-
-                    remove_client_from_rooms(fd);
-
-                    {
-                        std::lock_guard<std::mutex> lock(clients_mutex);
-                        clients.erase(
-                            std::remove_if(clients.begin(), clients.end(),
-                                [fd](const Client& c) {
-                                    if (c.fd == fd) {
-                                        close(c.fd);
-                                        return true;
-                                    }
-                                    return false;
-                                }),
-                            clients.end()
-                        );
-                    }
-
-                    epoll_ctl(epfd, EPOLL_CTL_DEL, fd, nullptr);
-                    broadcast_rooms();
-                    break;
-                }
+            Client* c = get_client(fd);
+            if (!c)
+                continue;
 
-                if (len < 0) {
-                    if (errno == EAGAIN || errno == EWOULDBLOCK)
-                        break;
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+                queue_ready(r, *c);
 
-                    remove_client_from_rooms(fd);
-
-                    {
-                        std::lock_guard<std::mutex> lock(clients_mutex);
-                        clients.erase(
-                            std::remove_if(clients.begin(), clients.end(),
-                                [fd](const Client& c) {
-                                    if (c.fd == fd) {
-                                        close(c.fd);
-                                        return true;
-                                    }
-                                    return false;
-                                }),
-                            clients.end()
-                        );
-                    }
+            if (events[i].events & EPOLLOUT)
+                flush_client(*c);
+        }
 
-                    epoll_ctl(epfd, EPOLL_CTL_DEL, fd, nullptr);
-                    broadcast_rooms();
-                    break;
-                }
+        serve_ready(r);
 
-                buffer[len] = 0;
-                data += buffer;
-            }
+        flush_dirty_rooms(r);
+        publish_lobby(r);
+        close_pending(r);
+        arm_timer(r);
+    }
+}
 
-            if (!data.empty())
-                process_client_data(fd, data);
+// Specyfikacja KLASA=na_sekundę/zapas, np. CHAT=2/5; CHAT=0 wyłącza limit.
+bool parse_rate_limit(const char* spec) {
+    const char* eq = strchr(spec, '=');
+    if (!eq)
+        return false;
+
+    std::string name(spec, eq - spec);
+    unsigned per_second = 0, burst = 0;
+    int fields = sscanf(eq + 1, "%u/%u", &per_second, &burst);
+    if (fields < 1 || per_second > 1000000)
+        return false;
+    if (fields == 1)
+        burst = per_second;
+
+    for (RateLimit& l : rate_limits) {
+        if (iequals(name, l.name)) {
+            l.per_second = per_second;
+            l.burst = burst > 0 ? burst : 1;
+            return true;
         }
+    }
+
+    return false;
+}
+
+// Odpowiedź dla Prometheusa: sumy liczników wszystkich reaktorów.
+std::string render_metrics() {
+    auto total = [](Counter ReactorMetrics::*field) {
+        uint64_t sum = 0;
+        for (Reactor* r : reactors)
+            sum += (r->metrics.*field).get();
+        return sum;
+    };
+
+    HistogramTotal<8, 20> latency[COMMAND_COUNT];
+    HistogramTotal<0, 16> room_fanout, game_fanout, lobby_fanout;
+
+    for (Reactor* r : reactors) {
+        for (int i = 0; i < COMMAND_COUNT; i++)
+            latency[i].merge(r->metrics.command_latency[i]);
+        room_fanout.merge(r->metrics.room_fanout);
+        game_fanout.merge(r->metrics.game_fanout);
+        lobby_fanout.merge(r->metrics.lobby_fanout);
+    }
+
+    uint64_t opened = total(&ReactorMetrics::connections_opened);
+    uint64_t created = total(&ReactorMetrics::rooms_created);
+    uint64_t started = total(&ReactorMetrics::games_started);
+
+    // Wartości bieżące to różnice liczników, bo np. połączenie może zostać
+    // otwarte w jednym reaktorze, a zamknięte w innym.
+    std::string out;
+    write_metric(out, "hangman_connections", "gauge", "Otwarte połączenia klientów.",
+                 opened - total(&ReactorMetrics::connections_closed));
+    write_metric(out, "hangman_connections_total", "counter", "Przyjęte połączenia.", opened);
+    write_metric(out, "hangman_rooms", "gauge", "Istniejące pokoje.",
+                 created - total(&ReactorMetrics::rooms_removed));
+    write_metric(out, "hangman_rooms_created_total", "counter", "Utworzone pokoje.", created);
+    write_metric(out, "hangman_games_active", "gauge", "Trwające rundy.",
+                 started - total(&ReactorMetrics::games_finished));
+    write_metric(out, "hangman_games_total", "counter", "Rozpoczęte rundy.", started);
+    write_metric(out, "hangman_messages_in_total", "counter", "Odebrane komendy.",
+                 total(&ReactorMetrics::messages_in));
+    write_metric(out, "hangman_bytes_in_total", "counter", "Odebrane bajty.",
+                 total(&ReactorMetrics::bytes_in));
+    write_metric(out, "hangman_messages_out_total", "counter", "Wysłane komunikaty.",
+                 total(&ReactorMetrics::messages_out));
+    write_metric(out, "hangman_bytes_out_total", "counter", "Wysłane bajty.",
+                 total(&ReactorMetrics::bytes_out));
+    write_metric(out, "hangman_messages_coalesced_total", "counter",
+                 "Niewysłane komunikaty zastąpione nowszą wersją.",
+                 total(&ReactorMetrics::messages_coalesced));
+    write_metric(out, "hangman_laggards_closed_total", "counter",
+                 "Klienci rozłączeni za zbyt długo czekające dane.",
+                 total(&ReactorMetrics::laggards_closed));
+
+    metric_header(out, "hangman_commands_limited_total", "counter",
+                  "Komendy odrzucone przez limit połączenia.");
+    for (int i = 0; i < RATE_CLASS_COUNT; i++) {
+        uint64_t sum = 0;
+        for (Reactor* r : reactors)
+            sum += r->metrics.commands_limited[i].get();
+        out += std::string("hangman_commands_limited_total{class=\"") + rate_limits[i].name +
+               "\"} " + std::to_string(sum) + "\n";
+    }
+
+    metric_header(out, "hangman_command_duration_seconds", "histogram",
+                  "Czas obsługi komendy w process_client_data.");
+    for (int i = 0; i < COMMAND_COUNT; i++) {
+        if (!latency[i].empty())
+            latency[i].write(out, "hangman_command_duration_seconds",
+                             std::string("command=\"") + COMMAND_NAMES[i] + "\"", 1e-9);
+    }
+
+    metric_header(out, "hangman_broadcast_recipients", "histogram",
+                  "Liczba odbiorców jednego rozgłoszenia.");
+    room_fanout.write(out, "hangman_broadcast_recipients", "kind=\"room\"", 1);
+    game_fanout.write(out, "hangman_broadcast_recipients", "kind=\"game\"", 1);
+    lobby_fanout.write(out, "hangman_broadcast_recipients", "kind=\"lobby\"", 1);
+
+    return out;
+}
+
+// Reaktor z własnym gniazdem nasłuchującym na port (SO_REUSEPORT), epoll,
+// eventfd do budzenia i timerfd dla koła zegarów; nullptr przy błędzie.
+Reactor* create_reactor(int id, int port) {
+    Reactor* r = new Reactor();
+    r->id = id;
+
+    r->listen_fd = create_listen_socket(port);
+    if (r->listen_fd < 0)
+        return nullptr;
+
+    r->epfd = epoll_create1(0);
+    if (r->epfd < 0) {
+        perror("epoll_create1");
+        return nullptr;
+    }
+
+    r->wake_fd = eventfd(0, EFD_NONBLOCK);
+    if (r->wake_fd < 0) {
+        perror("eventfd");
+        return nullptr;
+    }
+
+    r->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+    if (r->timer_fd < 0) {
+        perror("timerfd_create");
+        return nullptr;
+    }
+
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLET;
+    ev.data.fd = r->listen_fd;
+    epoll_ctl(r->epfd, EPOLL_CTL_ADD, r->listen_fd, &ev);
+
+    ev.events = EPOLLIN;
+    ev.data.fd = r->wake_fd;
+    epoll_ctl(r->epfd, EPOLL_CTL_ADD, r->wake_fd, &ev);
+
+    ev.data.fd = r->timer_fd;
+    epoll_ctl(r->epfd, EPOLL_CTL_ADD, r->timer_fd, &ev);
+
+    return r;
+}
 
-        static int tick = 0;
-        if (++tick % 10 == 0) {
-            broadcast_rooms();
+// server_bench dołącza ten plik bez main, żeby wywoływać funkcje serwera
+// bezpośrednio.
+#ifndef SERVER_NO_MAIN
+int main(int argc, char** argv) {
+    int reactor_count = std::thread::hardware_concurrency();
+    int opt;
 
-            std::lock_guard<std::mutex> lock(rooms_mutex);
-            for (auto room : rooms) {
-                if (room->state == GameState::PLAYING && room->game_running)
-                    send_game_state(room);
+    std::string leaderboard_path = "leaderboard";
+    int metrics_port = 5001;
+
+    while ((opt = getopt(argc, argv, "r:d:l:m:q:")) != -1) {
+        switch (opt) {
+        case 'r':
+            reactor_count = atoi(optarg);
+            break;
+        case 'd':
+            dictionary_path = optarg;
+            break;
+        case 'l':
+            leaderboard_path = optarg;
+            break;
+        case 'm':
+            metrics_port = atoi(optarg);
+            break;
+        case 'q':
+            if (!parse_rate_limit(optarg)) {
+                std::cerr << "Niepoprawny limit komend: " << optarg << std::endl;
+                return 1;
             }
+            break;
+        default:
+            std::cerr << "Użycie: " << argv[0]
+                      << " [-r liczba_reaktorów] [-d słownik.dict] [-l plik_wyników]"
+                      << " [-m port_metryk] [-q KLASA=na_sekundę/zapas]" << std::endl;
+            return 1;
+        }
+    }
+
+    // SIGHUP odbiera tylko reload_loop, więc musi być zablokowany, zanim
+    // powstanie jakikolwiek wątek - maskę dziedziczą też wątki loggera.
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGHUP);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    logger().start();
+
+    Dictionary* dict = new Dictionary();
+
+    if (!dictionary_path.empty()) {
+        if (!dict->open(dictionary_path)) {
+            std::cerr << "Niepoprawny plik słownika: " << dictionary_path << std::endl;
+            return 1;
         }
+    }
+    else {
+        dict->load(build_dictionary_image(word_list));
+    }
+
+    if (dict->word_count() == 0) {
+        std::cerr << "Słownik nie zawiera żadnych haseł" << std::endl;
+        return 1;
+    }
+
+    dictionary.store(dict);
+    std::cout << "Słownik: " << dict->word_count() << " haseł" << std::endl;
+
+    if (!leaderboard.open(leaderboard_path))
+        std::cerr << "Nie można otworzyć tablicy wyników " << leaderboard_path
+                  << " - wyniki nie będą zapisywane" << std::endl;
+
+    if (reactor_count < 1)
+        reactor_count = 1;
+
+    for (int i = 0; i < reactor_count; i++) {
+        Reactor* r = create_reactor(i, 5000);
+        if (!r)
+            return 1;
+        reactors.push_back(r);
+    }
+
+    std::cout << "Serwer nasłuchuje na porcie 5000 ("
+              << reactor_count << " reaktorów)..." << std::endl;
+    //std::cout << "Dostępne komendy: NAME, CREATE, JOIN, LEAVE, START, GUESS, READY" << std::endl;
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    // Przed reaktorami, żeby RELOAD zawsze miał dokąd wysłać sygnał.
+    std::thread reloader(reload_loop, signals);
+    reload_thread = reloader.native_handle();
+    reloader.detach();
+
+    std::thread(words_loop).detach();
+
+    for (Reactor* r : reactors)
+        r->thread = std::thread(reactor_loop, r);
+
+
+    if (metrics_port > 0) {
+        int metrics_fd = open_metrics_socket(metrics_port);
+        if (metrics_fd < 0)
+            LOG_ERROR("Nie można otworzyć portu metryk", "port", metrics_port,
+                      "error", strerror(errno));
+        else
+            std::thread(serve_metrics, metrics_fd, render_metrics).detach();
     }
 
-    for (auto r : rooms)
+    for (Reactor* r : reactors)
+        r->thread.join();
+
+
+    for (Reactor* r : reactors) {
+        close(r->listen_fd);
+        close(r->epfd);
+        close(r->wake_fd);
+        close(r->timer_fd);
         delete r;
+    }
 
-    close(listen_fd);
-    close(epfd);
     return 0;
 }
+#endif
@@ -0,0 +1,483 @@
+// Mikrobenchmarki gorących ścieżek serwera, uruchamiane w jednym procesie
+// na syntetycznych pokojach. Każdy przypadek to jedna linia JSON:
+//   {"bench":..., "rooms":..., "players":..., "ns_per_op":...,
+//    "allocs_per_op":..., "bytes_per_op":...}
+// bytes_per_op to bajty sformatowane przez operację: wstawione do kolejek
+// wysyłki (liczniki metryk reaktora) albo długość zwróconego napisu.
+//
+// Użycie: ./server_bench [fragment_nazwy]
+
+#define SERVER_NO_MAIN
+#include "server.cpp"
+
+#include <new>
+#include <cstdlib>
+#include <sys/resource.h>
+
+std::atomic<uint64_t> allocations{0};
+
+// noinline: po wstawieniu GCC widzi free() na pamięci z operator new
+// albo malloc() zwolnione przez operator delete i zgłasza
+// -Wmismatched-new-delete.
+__attribute__((noinline)) void* operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void* p) noexcept {
+    free(p);
+}
+
+__attribute__((noinline)) void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+const char* const BENCH_WORD = "PROGRAMOWANIE";
+const double BENCH_MIN_SECONDS = 0.2;
+
+std::string bench_filter;
+
+struct BenchResult {
+    uint64_t ops = 0;
+    uint64_t ns = 0;
+    uint64_t allocs = 0;
+    uint64_t bytes = 0;
+};
+
+// Odbiera wszystko, co serwer wysyła do klientów z prawdziwymi gniazdami,
+// żeby kolejki wyjściowe nie rosły w trakcie pomiaru.
+struct Sink {
+    int epfd = epoll_create1(0);
+    std::vector<int> ends;
+
+    int open_client() {
+        int sv[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) < 0) {
+            perror("socketpair");
+            exit(1);
+        }
+
+        int size = 4 << 20;
+        setsockopt(sv[0], SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+        fcntl(sv[0], F_SETFL, fcntl(sv[0], F_GETFL, 0) | O_NONBLOCK);
+
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = sv[1];
+        epoll_ctl(epfd, EPOLL_CTL_ADD, sv[1], &ev);
+        ends.push_back(sv[1]);
+
+        return sv[0];
+    }
+
+    void run() {
+        static char buf[1 << 20];
+        epoll_event events[64];
+
+        while (true) {
+            int n = epoll_wait(epfd, events, 64, 100);
+            for (int i = 0; i < n; i++)
+                while (recv(events[i].data.fd, buf, sizeof(buf), MSG_DONTWAIT) > 0) {}
+        }
+    }
+};
+
+Sink sink;
+std::vector<Client*> sink_clients;
+Reactor bench_reactor;
+int next_fake_fd = 1 << 20;
+
+// Klient bez gniazda - wystarcza tam, gdzie operacja niczego nie wysyła.
+Client* fake_client(const std::string& nick) {
+    int fd = next_fake_fd++;
+    Client* c = connections.insert(fd, bench_reactor.id);
+    attach_client(&bench_reactor, *c);
+    c->name = nicknames.reserve(nick);
+    c->input.prepare();
+    return c;
+}
+
+Client* sink_client(const std::string& nick) {
+    int fd = sink.open_client();
+    Client* c = connections.insert(fd, bench_reactor.id);
+    attach_client(&bench_reactor, *c);
+    c->name = nicknames.reserve(nick);
+    sink_clients.push_back(c);
+    return c;
+}
+
+// Pokój w trakcie rundy z ustalonym hasłem, żeby wyniki były porównywalne.
+Room* playing_room(const std::string& name, const std::vector<Client*>& members) {
+    bool busy;
+    Room* room = rooms.add(name, busy);
+
+    for (Client* c : members) {
+        room->client_fds.push_back(c->fd);
+        c->room_id = room->id;
+    }
+    room->member_count = room->client_fds.size();
+
+    init_game(room);
+    room->secret_word = BENCH_WORD;
+    room->word = compile_word(room->secret_word);
+    return room;
+}
+
+void reset_players(Room* room) {
+    RoundPlayers& p = room->players;
+    std::fill(p.stage.begin(), p.stage.end(), 0);
+    std::fill(p.flags.begin(), p.flags.end(), PLAYER_ACTIVE);
+    std::fill(p.changed.begin(), p.changed.end(), 0);
+    std::fill(p.tried.begin(), p.tried.end(), 0);
+    std::fill(p.revealed.begin(), p.revealed.end(), 0);
+    p.finish_order.clear();
+    room->state_dirty = false;
+}
+
+// Czeka, aż odbiornik opróżni wszystkie kolejki wyjściowe.
+void drain_outputs() {
+    for (Client* c : sink_clients) {
+        while (!c->closing && c->output.pending() > 0) {
+            flush_client(*c);
+            if (c->output.pending() > 0)
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+}
+
+uint64_t bytes_out() {
+    return bench_reactor.metrics.bytes_out.get();
+}
+
+// Powtarza partie operacji do uzbierania BENCH_MIN_SECONDS pomiaru. prepare()
+// działa poza pomiarem; batch() wykonuje ops operacji i zwraca bajty
+// sformatowane poza kolejkami wysyłki.
+template <typename Prepare, typename Batch>
+BenchResult measure(uint64_t ops, Prepare prepare, Batch batch) {
+    BenchResult res;
+
+    while (res.ns < BENCH_MIN_SECONDS * 1e9 || res.ops < 3 * ops) {
+        prepare();
+
+        uint64_t allocs_before = allocations.load(std::memory_order_relaxed);
+        uint64_t out_before = bytes_out();
+        auto start = std::chrono::steady_clock::now();
+
+        uint64_t formatted = batch();
+
+        auto end = std::chrono::steady_clock::now();
+        res.ns += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+        res.allocs += allocations.load(std::memory_order_relaxed) - allocs_before;
+        res.bytes += formatted + bytes_out() - out_before;
+        res.ops += ops;
+
+        drain_outputs();
+    }
+
+    return res;
+}
+
+void report(const char* bench, int room_count, int players, const BenchResult& res) {
+    printf("{\"bench\":\"%s\",\"rooms\":%d,\"players\":%d,\"ops\":%lu,"
+           "\"ns_per_op\":%.1f,\"allocs_per_op\":%.2f,\"bytes_per_op\":%.1f}\n",
+           bench, room_count, players, (unsigned long)res.ops,
+           (double)res.ns / res.ops, (double)res.allocs / res.ops,
+           (double)res.bytes / res.ops);
+    fflush(stdout);
+}
+
+bool selected(const char* bench) {
+    return bench_filter.empty() || strstr(bench, bench_filter.c_str());
+}
+
+// Pokoje po 5 graczy bez gniazd: GUESS przez process_client_data (parsowanie,
+// wyszukanie klienta i pokoju, ruch) oraz budowa i rozesłanie listy ROOMS.
+void bench_rooms(int room_count, std::vector<Room*>& all, std::vector<Client*>& players,
+                 const std::vector<Client*>& lobby) {
+    while ((int)all.size() < room_count) {
+        std::vector<Client*> members;
+        for (int k = 0; k < 5; k++) {
+            members.push_back(fake_client("p" + std::to_string(players.size())));
+            players.push_back(members.back());
+        }
+        all.push_back(playing_room("room" + std::to_string(all.size()), members));
+    }
+
+    if (selected("process_client_data")) {
+        int pass = 0;
+        BenchResult res = measure(players.size(), [&]() {
+            for (Room* room : all)
+                reset_players(room);
+            bench_reactor.dirty_rooms.clear();
+        }, [&]() {
+            char line[] = "GUESS A\n";
+            line[6] = 'A' + pass++ % 26;
+
+            for (Client* c : players) {
+                LineBuffer& in = c->input;
+                in.prepare();
+                memcpy(in.tail(), line, sizeof(line) - 1);
+                in.commit(sizeof(line) - 1);
+                int budget = COMMAND_BUDGET;
+                process_client_data(c->fd, budget);
+            }
+            return (uint64_t)0;
+        });
+        report("process_client_data", room_count, 5, res);
+    }
+
+    if (selected("lobby_snapshot")) {
+        BenchResult res = measure(1, []() {
+            lobby_version.fetch_add(1);
+        }, []() {
+            uint64_t version;
+            return (uint64_t)lobby_snapshot(version)->size();
+        });
+        report("lobby_snapshot", room_count, 0, res);
+    }
+
+    if (selected("publish_lobby")) {
+        BenchResult res = measure(1, []() {
+            lobby_version.fetch_add(1);
+        }, []() {
+            publish_lobby(&bench_reactor);
+            return (uint64_t)0;
+        });
+        report("publish_lobby", room_count, (int)lobby.size(), res);
+    }
+}
+
+// Jeden pokój z graczami na prawdziwych gniazdach.
+void bench_players(int count) {
+    std::vector<Client*> members;
+    for (int i = 0; i < count; i++)
+        members.push_back(sink_client("g" + std::to_string(count) + "_" + std::to_string(i)));
+
+    Room* room = playing_room("big" + std::to_string(count), members);
+    RoundPlayers& p = room->players;
+
+    if (selected("process_guess")) {
+        int pass = 0;
+        BenchResult res = measure(count, [&]() { reset_players(room); }, [&]() {
+            char letter = 'A' + pass++ % 26;
+            for (int i = 0; i < count; i++)
+                process_guess(room, i, letter);
+            return (uint64_t)0;
+        });
+        report("process_guess", 1, count, res);
+    }
+
+    // Stan w połowie rundy: każdy gracz ma kilka prób, część już odgadła.
+    auto mid_round = [&]() {
+        reset_players(room);
+        for (int i = 0; i < count; i++) {
+            for (char ch : std::string("AEOQXZ").substr(0, 1 + i % 6))
+                process_guess(room, i, ch);
+            if (i % 3 == 0) {
+                p.revealed[i] = room->word.full;
+                p.finish(i, 1000 + i);
+            }
+        }
+    };
+
+    if (selected("send_game_state")) {
+        BenchResult res = measure(4, mid_round, [&]() {
+            for (int k = 0; k < 4; k++)
+                send_game_state(room);
+            return (uint64_t)0;
+        });
+        report("send_game_state", 1, count, res);
+    }
+
+    if (selected("build_ranking")) {
+        BenchResult res = measure(16, mid_round, [&]() {
+            uint64_t bytes = 0;
+            for (int k = 0; k < 16; k++)
+                bytes += build_ranking(room).size();
+            return bytes;
+        });
+        report("build_ranking", 1, count, res);
+    }
+}
+
+// Gracz w układzie sprzed masek bitowych (PlayerState z vector<bool> pozycji
+// i listami liter): punkt odniesienia dla process_guess.
+struct ScanPlayer {
+    int hangman_stage = 0;
+    std::vector<bool> guessed_letters;
+    std::vector<char> correct_letters;
+    std::vector<char> wrong_letters;
+};
+
+bool scan_guess(Room* room, ScanPlayer& player, char letter) {
+    letter = toupper(letter);
+
+    if (std::find(player.correct_letters.begin(), player.correct_letters.end(), letter) != player.correct_letters.end() ||
+        std::find(player.wrong_letters.begin(), player.wrong_letters.end(), letter) != player.wrong_letters.end())
+        return false;
+
+    bool found = false;
+    for (size_t i = 0; i < room->secret_word.size(); ++i) {
+        if (room->secret_word[i] == letter) {
+            player.guessed_letters[i] = true;
+            found = true;
+        }
+    }
+
+    if (found) {
+        player.correct_letters.push_back(letter);
+
+        bool complete = true;
+        for (bool g : player.guessed_letters) {
+            if (!g) {
+                complete = false;
+                break;
+            }
+        }
+
+        if (complete)
+            LOG_INFO("Gracz odgadł hasło", "room", room->name, "nick", *room->players.name[0]);
+    } else {
+        player.wrong_letters.push_back(letter);
+        player.hangman_stage++;
+    }
+
+    return true;
+}
+
+// Cała runda jednego gracza: 23 litery od świeżego stanu, raz przez
+// process_guess, raz przez przeszukiwanie hasła jak przed maskami.
+void bench_guess_sequence() {
+    const std::string sequence = "EAIOUKMNRSTLPCDGBWZYJHF";
+
+    Room* room = playing_room("sequence", {fake_client("seq")});
+
+    if (selected("guess_sequence")) {
+        BenchResult res = measure(sequence.size() * 64, []() {}, [&]() {
+            for (int k = 0; k < 64; k++) {
+                reset_players(room);
+                for (char ch : sequence)
+                    process_guess(room, 0, ch);
+            }
+            return (uint64_t)0;
+        });
+        report("guess_sequence", 1, 1, res);
+    }
+
+    if (selected("guess_sequence_scan")) {
+        BenchResult res = measure(sequence.size() * 64, []() {}, [&]() {
+            int stages = 0;
+            for (int k = 0; k < 64; k++) {
+                ScanPlayer player;
+                player.guessed_letters.assign(room->secret_word.size(), false);
+                for (char ch : sequence)
+                    scan_guess(room, player, ch);
+                stages += player.hangman_stage;
+            }
+            asm volatile("" : : "r"(stages));
+            return (uint64_t)0;
+        });
+        report("guess_sequence_scan", 1, 1, res);
+    }
+}
+
+// Wyszukanie połączenia po deskryptorze wśród count otwartych: tabela
+// indeksowana fd oraz liniowe przeszukanie wektora klientów, jak w reaktorach
+// przed ConnectionTable.
+void bench_connections(int count) {
+    std::vector<int> fds;
+    std::vector<Client> linear(count);
+    for (int i = 0; i < count; i++) {
+        int fd = next_fake_fd++;
+        connections.insert(fd, bench_reactor.id);
+        linear[i].fd = fd;
+        fds.push_back(fd);
+    }
+
+    std::mt19937 gen(count);
+    std::vector<int> probes(4096);
+    for (int& fd : probes)
+        fd = fds[gen() % fds.size()];
+
+    if (selected("connection_lookup")) {
+        BenchResult res = measure(probes.size(), []() {}, [&]() {
+            uint64_t found = 0;
+            for (int fd : probes)
+                found += connections.find(fd, bench_reactor.id) != nullptr;
+            asm volatile("" : : "r"(found));
+            return (uint64_t)0;
+        });
+        report("connection_lookup", 0, count, res);
+    }
+
+    if (selected("connection_lookup_linear")) {
+        size_t batch = count >= 100000 ? 64 : 1024;
+        BenchResult res = measure(batch, []() {}, [&]() {
+            uint64_t found = 0;
+            for (size_t k = 0; k < batch; k++) {
+                int fd = probes[k];
+                auto it = std::find_if(linear.begin(), linear.end(),
+                    [fd](const Client& c) { return c.fd == fd; });
+                found += it != linear.end();
+            }
+            asm volatile("" : : "r"(found));
+            return (uint64_t)0;
+        });
+        report("connection_lookup_linear", 0, count, res);
+    }
+
+    for (int fd : fds)
+        connections.erase(fd);
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1)
+        bench_filter = argv[1];
+
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    // Benchmark wysyła setki GUESS na połączenie w ułamku sekundy.
+    for (RateLimit& l : rate_limits)
+        l.per_second = 0;
+
+    Dictionary* dict = new Dictionary();
+    dict->load(build_dictionary_image(word_list));
+    dictionary.store(dict);
+
+    bench_reactor.id = 0;
+    bench_reactor.epfd = epoll_create1(0);
+    bench_reactor.wake_fd = eventfd(0, EFD_NONBLOCK);
+    reactors.push_back(&bench_reactor);
+    current_reactor = &bench_reactor;
+
+    std::thread([]() { sink.run(); }).detach();
+
+    std::vector<Client*> lobby;
+    for (int i = 0; i < 100; i++)
+        lobby.push_back(sink_client("lobby" + std::to_string(i)));
+
+    std::vector<Room*> all;
+    std::vector<Client*> players;
+    for (int room_count : {10, 1000, 10000})
+        bench_rooms(room_count, all, players, lobby);
+
+    for (int count : {5, 50, 500})
+        bench_players(count);
+
+    bench_guess_sequence();
+
+    for (int count : {10000, 100000})
+        bench_connections(count);
+
+    if (!bench_reactor.closing.empty())
+        fprintf(stderr, "Uwaga: %zu klientów rozłączonych w trakcie pomiaru\n",
+                bench_reactor.closing.size());
+
+    return 0;
+}